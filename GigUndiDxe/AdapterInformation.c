@@ -149,6 +149,118 @@ GetMediaTypeInformationBlock (
   return EFI_SUCCESS;
 }
 
+/** Gets loopback performance test information block
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      Loopback performance information block.
+  @param[out]  InformationBlockSize  Loopback performance information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store loopback performance info
+**/
+STATIC
+EFI_STATUS
+GetLoopbackPerfInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  ADAPTER_INFO_LOOPBACK_PERF  *Buffer;
+  UNDI_PRIVATE_DATA           *UndiPrivateData;
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+
+  Buffer = AllocateCopyPool (sizeof (ADAPTER_INFO_LOOPBACK_PERF), &UndiPrivateData->LoopbackPerf);
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("Failed to allocate Buffer!\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (ADAPTER_INFO_LOOPBACK_PERF);
+
+  return EFI_SUCCESS;
+}
+
+/** Gets link and traffic health information block
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      Health information block.
+  @param[out]  InformationBlockSize  Health information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store health info
+**/
+STATIC
+EFI_STATUS
+GetHealthInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  ADAPTER_INFO_HEALTH  *Buffer;
+  UNDI_PRIVATE_DATA    *UndiPrivateData;
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+
+  Buffer = AllocateCopyPool (sizeof (ADAPTER_INFO_HEALTH), &UndiPrivateData->Health.Info);
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("Failed to allocate Buffer!\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (ADAPTER_INFO_HEALTH);
+
+  return EFI_SUCCESS;
+}
+
+/** Sets loopback performance test configuration used by the next
+  manufacturing diagnostic run
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[in]   InformationBlock      Loopback performance information block.
+  @param[in]   InformationBlockSize  Loopback performance information block size.
+
+  @retval      EFI_SUCCESS            Configuration stored
+  @retval      EFI_INVALID_PARAMETER  Block size or configuration is invalid
+**/
+STATIC
+EFI_STATUS
+SetLoopbackPerfInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  IN  VOID *                            InformationBlock,
+  IN  UINTN                             InformationBlockSize
+  )
+{
+  LOOPBACK_PERF_CONFIG  *Config;
+  UNDI_PRIVATE_DATA     *UndiPrivateData;
+
+  if (InformationBlockSize < sizeof (LOOPBACK_PERF_CONFIG)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Config = &((ADAPTER_INFO_LOOPBACK_PERF *) InformationBlock)->Config;
+
+  if ((Config->LoopbackMode > LOOPBACK_PERF_MODE_PHY)
+    || (Config->InFlight > DEFAULT_TX_DESCRIPTORS)
+    || (Config->FrameCount > LOOPBACK_PERF_MAX_FRAMES)
+    || ((Config->FrameSize != 0)
+    && ((Config->FrameSize < LOOPBACK_PERF_MIN_FRAME_SIZE)
+    || (Config->FrameSize > LOOPBACK_PERF_MAX_FRAME_SIZE))))
+  {
+    DEBUGPRINT (ADAPTERINFO, ("Invalid loopback performance configuration\n"));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  CopyMem (&UndiPrivateData->LoopbackPerf.Config, Config, sizeof (LOOPBACK_PERF_CONFIG));
+
+  return EFI_SUCCESS;
+}
+
 /** Returns the current state information for the adapter
 
    @param[in]   This                   Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
@@ -384,10 +496,13 @@ InitAdapterInformationProtocol (
   EFI_GUID MediaStateGuid      = EFI_ADAPTER_INFO_MEDIA_STATE_GUID;
   EFI_GUID Ipv6SupportInfoGuid = EFI_ADAPTER_INFO_UNDI_IPV6_SUPPORT_GUID;
   EFI_GUID MediaTypeGuid       = EFI_ADAPTER_INFO_MEDIA_TYPE_GUID;
+  EFI_GUID LoopbackPerfGuid    = ADAPTER_INFO_LOOPBACK_PERF_GUID;
+  EFI_GUID HealthGuid          = ADAPTER_INFO_HEALTH_GUID;
 
   DEBUGPRINT (ADAPTERINFO, ("%a, %d\n", __FUNCTION__, __LINE__));
 
   UndiPrivateData->AdapterInformation = gUndiAdapterInfo;
+  UndiPrivateData->LoopbackPerf.Result.Status = EFI_NOT_STARTED;
 
   ZeroMem (&InformationType, sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR));
   CopyMem (&InformationType.Guid, &MediaStateGuid, sizeof (EFI_GUID));
@@ -408,6 +523,18 @@ InitAdapterInformationProtocol (
   InformationType.SetInformationBlock = NULL;
   AddSupportedInformationType (&InformationType);
 
+  ZeroMem (&InformationType, sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR));
+  CopyMem (&InformationType.Guid, &LoopbackPerfGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetLoopbackPerfInformationBlock;
+  InformationType.SetInformationBlock = SetLoopbackPerfInformationBlock;
+  AddSupportedInformationType (&InformationType);
+
+  ZeroMem (&InformationType, sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR));
+  CopyMem (&InformationType.Guid, &HealthGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetHealthInformationBlock;
+  InformationType.SetInformationBlock = NULL;
+  AddSupportedInformationType (&InformationType);
+
   Status = gBS->InstallProtocolInterface (
                   &UndiPrivateData->DeviceHandle,
                   &gEfiAdapterInformationProtocolGuid,
@@ -60,6 +60,82 @@ typedef struct {
 
 #define MAX_SUPPORTED_INFORMATION_TYPE 20
 
+/* Loopback performance test configuration and last result. The block is read
+   with GetInformation(), SetInformation() only takes the Config part, which is
+   used by the next EfiDriverDiagnosticTypeManufacturing run. */
+#define ADAPTER_INFO_LOOPBACK_PERF_GUID \
+  { 0x5f0b7c3e, 0x2d41, 0x4a8e, { 0x9b, 0x16, 0x7c, 0xe4, 0x03, 0xa2, 0x51, 0xd9 } }
+
+#define LOOPBACK_PERF_MODE_MAC        0
+#define LOOPBACK_PERF_MODE_PHY        1
+
+#define LOOPBACK_PERF_MIN_FRAME_SIZE  60
+#define LOOPBACK_PERF_MAX_FRAME_SIZE  1514
+#define LOOPBACK_PERF_MAX_FRAMES      1000000
+
+typedef struct {
+  UINT8   LoopbackMode;     // LOOPBACK_PERF_MODE_xxx
+  UINT8   InFlight;         // frames kept outstanding, 0 for a full Tx ring
+  UINT16  FrameSize;        // frame size without CRC, 0 for a mix of sizes
+  UINT32  FrameCount;       // frames to send, 0 for the default count
+} LOOPBACK_PERF_CONFIG;
+
+typedef struct {
+  EFI_STATUS  Status;       // EFI_NOT_STARTED until the first run
+  UINT32      FramesSent;
+  UINT32      FramesReceived;
+  UINT32      FramesCorrupted;
+  UINT32      Reserved;
+  UINT64      BytesReceived;
+  UINT64      ElapsedNs;
+  UINT64      FramesPerSecond;
+  UINT64      BytesPerSecond;
+  UINT32      LatencyMinNs;
+  UINT32      LatencyAvgNs;
+  UINT32      LatencyP50Ns;
+  UINT32      LatencyP90Ns;
+  UINT32      LatencyP99Ns;
+  UINT32      LatencyMaxNs;
+} LOOPBACK_PERF_RESULT;
+
+typedef struct {
+  LOOPBACK_PERF_CONFIG  Config;
+  LOOPBACK_PERF_RESULT  Result;
+} ADAPTER_INFO_LOOPBACK_PERF;
+
+/* Link and traffic health as sampled by the Driver Health monitor. Conditions
+   are the ones currently reported through EFI_DRIVER_HEALTH_PROTOCOL, counters
+   are totals since the monitor was started. */
+#define ADAPTER_INFO_HEALTH_GUID \
+  { 0x8a3d61f2, 0x6c57, 0x4e0b, { 0xa4, 0x9e, 0x21, 0xd7, 0x5b, 0x0c, 0xe8, 0x36 } }
+
+#define HEALTH_CONDITION_RX_NO_BUFFER     BIT0
+#define HEALTH_CONDITION_RX_MISSED        BIT1
+#define HEALTH_CONDITION_RX_ERRORS        BIT2
+#define HEALTH_CONDITION_RX_ERRORS_HIGH   BIT3
+#define HEALTH_CONDITION_LINK_DOWNSHIFT   BIT4
+#define HEALTH_CONDITION_HALF_DUPLEX      BIT5
+#define HEALTH_CONDITION_COLLISIONS       BIT6
+#define HEALTH_CONDITION_LINK_FLAP        BIT7
+#define HEALTH_CONDITION_LINK_FLAP_HIGH   BIT8
+#define HEALTH_CONDITION_COUNT            9
+
+typedef struct {
+  UINT32   Conditions;          // HEALTH_CONDITION_xxx
+  UINT32   SamplePeriodMs;
+  UINT32   Samples;
+  UINT32   LinkLosses;          // link losses in the current flap window
+  UINT16   LinkSpeed;           // Mb/s, 0 when link is down
+  BOOLEAN  FullDuplex;
+  UINT8    Reserved;
+  UINT64   RxGood;
+  UINT64   TxGood;
+  UINT64   RxNoBuffer;          // RNBC
+  UINT64   RxMissed;            // MPC
+  UINT64   RxErrors;            // CRCERRS + ALGNERRC
+  UINT64   ExcessiveCollisions; // ECOL
+} ADAPTER_INFO_HEALTH;
+
 /** Adds supported Information Type Descriptor to the list.
   Call before protocol installation.
 
@@ -220,3 +220,5 @@ BRAND_STRUCT mBrandingTable[] = {
 };
 
 UINTN mBrandingTableSize = (sizeof (mBrandingTable) / sizeof (mBrandingTable[0]));
+
+UINT16 mBrandingIndex[sizeof (mBrandingTable) / sizeof (mBrandingTable[0])];
@@ -779,7 +779,7 @@ E1000UndiGetConfigInfo (
     AdapterInfo->Function)
   );
 
-  CopyMem (DbPtr->pci.Config.Dword, &AdapterInfo->PciConfig, MAX_PCI_CONFIG_LEN * sizeof (UINT32));
+  CopyMem (DbPtr->pci.Config.Dword, AdapterInfo->Cold->PciConfig, MAX_PCI_CONFIG_LEN * sizeof (UINT32));
 
   CdbPtr->StatFlags = PXE_STATFLAGS_COMMAND_COMPLETE;
   CdbPtr->StatCode = PXE_STATCODE_SUCCESS;
@@ -854,6 +854,7 @@ E1000UndiInitialize (
   AdapterInfo->LinkSpeed     = (UINT16) CpbPtr->LinkSpeed;
   AdapterInfo->DuplexMode    = CpbPtr->DuplexMode;
   AdapterInfo->LoopBack      = CpbPtr->LoopBackMode;
+  AdapterInfo->RxRingRequest = CpbPtr->RxBufCnt;
 
   DEBUGPRINT (DECODE, ("CpbPtr->TxBufCnt = %X\n", CpbPtr->TxBufCnt));
   DEBUGPRINT (DECODE, ("CpbPtr->TxBufSize = %X\n", CpbPtr->TxBufSize));
@@ -873,7 +874,7 @@ E1000UndiInitialize (
   DbPtr->MemoryUsed = 0;
   DbPtr->TxBufCnt   = DEFAULT_TX_DESCRIPTORS;
   DbPtr->TxBufSize  = sizeof (E1000_TRANSMIT_DESCRIPTOR);
-  DbPtr->RxBufCnt   = DEFAULT_RX_DESCRIPTORS;
+  DbPtr->RxBufCnt   = AdapterInfo->RxRing.BufferCount;
   DbPtr->RxBufSize  = sizeof (E1000_RECEIVE_DESCRIPTOR) + sizeof (LOCAL_RX_BUFFER);
 
   if (CdbPtr->StatCode != PXE_STATCODE_SUCCESS) {
@@ -1493,13 +1494,17 @@ E1000UndiStatus (
 
   // Fill in size of next available receive packet and
   // reserved field in caller's DB storage.
-  Status = ReceiveIsPacketReady (
-             AdapterInfo,
-             &RxPacketLength,
-             NULL,
-             NULL,
-             NULL
-             );
+  Status = RxPriorityRingIsPacketReady (AdapterInfo, &RxPacketLength);
+
+  if (Status != EFI_SUCCESS) {
+    Status = ReceiveIsPacketReady (
+               AdapterInfo,
+               &RxPacketLength,
+               NULL,
+               NULL,
+               NULL
+               );
+  }
 
   if (Status == EFI_SUCCESS) {
     DbPtr->RxFrameLen = RxPacketLength;
@@ -28,14 +28,97 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 
 #include "DeviceSupport.h"
+#include "wol.h"
 
 #if !defined (UNDI_IDPF) && !defined (SWITCH_MODE)
 #include "EepromConfig.h"
 #endif /* !defined (UNDI_IAVF) && !defined (UNDI_IDPF) && !defined (SWITCH_MODE) */
 
 
+STATIC BOOLEAN mBrandingIndexReady = FALSE;
+
+/** Compares two branding table entries by (DeviceId, SubvendorId, SubsystemId),
+   table position breaks ties.
+
+   @param[in]   A   Position of the first entry in mBrandingTable
+   @param[in]   B   Position of the second entry in mBrandingTable
+
+   @retval   TRUE    Entry A sorts before entry B
+   @retval   FALSE   Entry A sorts after entry B
+**/
+STATIC
+BOOLEAN
+IsBrandingEntryBefore (
+  UINTN A,
+  UINTN B
+  )
+{
+  BRAND_STRUCT *EntryA = &mBrandingTable[A];
+  BRAND_STRUCT *EntryB = &mBrandingTable[B];
+
+  if (EntryA->DeviceId != EntryB->DeviceId) {
+    return EntryA->DeviceId < EntryB->DeviceId;
+  }
+  if (EntryA->SubvendorId != EntryB->SubvendorId) {
+    return EntryA->SubvendorId < EntryB->SubvendorId;
+  }
+  if (EntryA->SubsystemId != EntryB->SubsystemId) {
+    return EntryA->SubsystemId < EntryB->SubsystemId;
+  }
+  return A < B;
+}
+
+/** Returns the first mBrandingIndex position of entries with given device ID,
+   building the index on first use.
+
+   @param[in]   DeviceId   Device ID to look for
+
+   @return   Index position, mBrandingTableSize when the device ID sorts last
+**/
+STATIC
+UINTN
+BrandingIndexLowerBound (
+  UINT16 DeviceId
+  )
+{
+  UINTN i;
+  UINTN j;
+  UINTN Low;
+  UINTN High;
+  UINTN Mid;
+
+  if (!mBrandingIndexReady) {
+
+    // Insertion sort, done once for a table of a few hundred entries
+    for (i = 0; i < mBrandingTableSize; i++) {
+      for (j = i; (j > 0) && IsBrandingEntryBefore (i, mBrandingIndex[j - 1]); j--) {
+        mBrandingIndex[j] = mBrandingIndex[j - 1];
+      }
+      mBrandingIndex[j] = (UINT16) i;
+    }
+    mBrandingIndexReady = TRUE;
+  }
+
+  Low  = 0;
+  High = mBrandingTableSize;
+  while (Low < High) {
+    Mid = Low + (High - Low) / 2;
+    if (mBrandingTable[mBrandingIndex[Mid]].DeviceId < DeviceId) {
+      Low = Mid + 1;
+    } else {
+      High = Mid;
+    }
+  }
+
+  return Low;
+}
+
 /** Seeks for current device's entry in branding table
 
+   Only the entries of the device ID and the vendor wildcard entries are
+   visited. The result is the one a scan of the whole table returns: the first
+   exact match, otherwise the last entry of the most specific wildcard match.
+
    @param[in]   VendorId      Device's vendor ID
    @param[in]   DeviceId      Device's device ID
    @param[in]   SubvendorId   Device's subvendor ID
@@ -55,63 +138,73 @@ FindDeviceInTableByIds (
   )
 {
   UINTN         i;
+  UINTN         Entry;
   BRAND_STRUCT *Device = NULL;
-
-  if (ExactMatch) {
-    for (i = 0; i < mBrandingTableSize; i++) {
-      if ((VendorId == mBrandingTable[i].VendorId) &&
-        (DeviceId == mBrandingTable[i].DeviceId) &&
-        (SubvendorId == mBrandingTable[i].SubvendorId) &&
-        (SubdeviceId == mBrandingTable[i].SubsystemId))
-      {
-        Device = &mBrandingTable[i];
-        break;
-      }
+  INTN          SubsystemMatch  = -1;
+  INTN          SubvendorMatch  = -1;
+  INTN          DeviceMatch = -1;
+  INTN          VendorMatch = -1;
+
+  for (i = BrandingIndexLowerBound (DeviceId); i < mBrandingTableSize; i++) {
+    Entry = mBrandingIndex[i];
+    if (mBrandingTable[Entry].DeviceId != DeviceId) {
+      break;
     }
-  } else {
-    INTN SubsystemMatch  = -1;
-    INTN SubvendorMatch  = -1;
-    INTN DeviceMatch = -1;
-    INTN VendorMatch = -1;
-
-    for (i = 0; i < mBrandingTableSize; i++) {
-      if (VendorId == mBrandingTable[i].VendorId) {
-        if (DeviceId == mBrandingTable[i].DeviceId) {
-          if (SubvendorId == mBrandingTable[i].SubvendorId) {
-            if (SubdeviceId == mBrandingTable[i].SubsystemId) {
-              SubsystemMatch = i;
-              break;
-            } else if (mBrandingTable[i].SubsystemId == WILD_CARD) {
-              SubvendorMatch = i;
-            }
-          } else if (mBrandingTable[i].SubvendorId == WILD_CARD) {
-            DeviceMatch = i;
-          }
-        } else if (mBrandingTable[i].DeviceId == WILD_CARD) {
-          VendorMatch = i;
-        }
-      }
+    if (VendorId != mBrandingTable[Entry].VendorId) {
+      continue;
     }
-    do {
-      if (SubsystemMatch != -1) {
-        Device = &mBrandingTable[SubsystemMatch];
-        break;
-      }
-      if (SubvendorMatch != -1) {
-        Device = &mBrandingTable[SubvendorMatch];
+    if (SubvendorId == mBrandingTable[Entry].SubvendorId) {
+      if (SubdeviceId == mBrandingTable[Entry].SubsystemId) {
+        // Entries with equal IDs are in table order, the first one wins
+        SubsystemMatch = Entry;
         break;
+      } else if (mBrandingTable[Entry].SubsystemId == WILD_CARD) {
+        SubvendorMatch = MAX (SubvendorMatch, (INTN) Entry);
       }
-      if (DeviceMatch != -1) {
-        Device = &mBrandingTable[DeviceMatch];
+    } else if (mBrandingTable[Entry].SubvendorId == WILD_CARD) {
+      DeviceMatch = MAX (DeviceMatch, (INTN) Entry);
+    }
+  }
+
+  if (ExactMatch) {
+    return (SubsystemMatch != -1) ? &mBrandingTable[SubsystemMatch] : NULL;
+  }
+
+  if ((SubsystemMatch == -1)
+    && (SubvendorMatch == -1)
+    && (DeviceMatch == -1)
+    && (DeviceId != WILD_CARD))
+  {
+    for (i = BrandingIndexLowerBound (WILD_CARD); i < mBrandingTableSize; i++) {
+      Entry = mBrandingIndex[i];
+      if (mBrandingTable[Entry].DeviceId != WILD_CARD) {
         break;
       }
-      if (VendorMatch != -1) {
-        Device = &mBrandingTable[VendorMatch];
-        break;
+      if (VendorId == mBrandingTable[Entry].VendorId) {
+        VendorMatch = MAX (VendorMatch, (INTN) Entry);
       }
-    } while (0);
-
+    }
   }
+
+  do {
+    if (SubsystemMatch != -1) {
+      Device = &mBrandingTable[SubsystemMatch];
+      break;
+    }
+    if (SubvendorMatch != -1) {
+      Device = &mBrandingTable[SubvendorMatch];
+      break;
+    }
+    if (DeviceMatch != -1) {
+      Device = &mBrandingTable[DeviceMatch];
+      break;
+    }
+    if (VendorMatch != -1) {
+      Device = &mBrandingTable[VendorMatch];
+      break;
+    }
+  } while (0);
+
   return Device;
 }
 
@@ -155,6 +248,10 @@ GetDeviceBrandingString (
   BRAND_STRUCT *Device = NULL;
   CHAR16 *      BrandingString = NULL;
 
+  // Resolved once at controller start
+  if (UndiPrivateData->Brand != NULL) {
+    return UndiPrivateData->Brand;
+  }
 
   // It will return last, INVALID entry at least
   Device = FindDeviceInTable (UndiPrivateData, FALSE);
@@ -182,13 +279,14 @@ IsDeviceIdSupported (
 {
   UINTN i;
 
-  if (VendorId == INTEL_VENDOR_ID) {
-    for (i = 0; i < mBrandingTableSize; i++) {
-      if (mBrandingTable[i].DeviceId != INVALID_DEVICE_ID) {
-        if (DeviceId == mBrandingTable[i].DeviceId) {
-          return TRUE;
-        }
-      }
+  if ((VendorId == INTEL_VENDOR_ID)
+    && (DeviceId != INVALID_DEVICE_ID))
+  {
+    i = BrandingIndexLowerBound (DeviceId);
+    if ((i < mBrandingTableSize)
+      && (mBrandingTable[mBrandingIndex[i]].DeviceId == DeviceId))
+    {
+      return TRUE;
     }
   }
   return FALSE;
@@ -203,5 +301,7 @@ SetStaticAdapterSupportFlags (
   IN  UNDI_PRIVATE_DATA  *UndiPrivateData
   )
 {
+  UndiPrivateData->Brand          = GetDeviceBrandingString (UndiPrivateData);
+  UndiPrivateData->IsWolSupported = WolIsWakeOnLanSupported (UndiPrivateData);
 }
 
@@ -44,6 +44,10 @@ typedef struct BRAND_STRUCT_S {
 extern BRAND_STRUCT mBrandingTable[];
 extern UINTN        mBrandingTableSize;
 
+// mBrandingTable positions ordered by (DeviceId, SubvendorId, SubsystemId),
+// table order among equal keys. Filled on first lookup.
+extern UINT16       mBrandingIndex[];
+
 
 /* Defines */
 #define INVALID_VENDOR_ID     0xFFFF
@@ -98,6 +102,9 @@ FindDeviceInTable (
 
 /** Sets adapter support information flags.
 
+   Resolves the branding string and WoL support of the controller once, so
+   later queries do not search the device tables again.
+
    @param[in]   UndiPrivateData   Points to the driver instance private data
 **/
 VOID
@@ -262,3 +262,279 @@ UndiDmaUnmapMemory (
   return Status;
 }
 
+/** Allocate and map the DMA region sub-allocations are carved from
+
+    @param[in]  PciIo         Pointer to PCI IO protocol installed on controller
+                              handle.
+    @param[in]  Region        Pointer to zeroed DMA region structure.
+    @param[in]  Size          Size of the region in bytes.
+
+    @retval     EFI_INVALID_PARAMETER   Bad arguments provided.
+    @retval     EFI_ALREADY_STARTED     Region is already allocated.
+    @retval     EFI_OUT_OF_RESOURCES    Failed to map whole requested area
+    @retval     EFI_SUCCESS             Allocation succeeded.
+**/
+EFI_STATUS
+UndiDmaRegionCreate (
+  EFI_PCI_IO_PROTOCOL       *PciIo,
+  UNDI_DMA_REGION           *Region,
+  UINTN                     Size
+  )
+{
+  EFI_STATUS    Status;
+
+  if (PciIo == NULL || Region == NULL || Size == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Region->Mapping.Size != 0) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  ZeroMem (Region, sizeof (UNDI_DMA_REGION));
+
+  Region->Mapping.Size = Size;
+
+  Status = UndiDmaAllocateCommonBuffer (PciIo, &Region->Mapping);
+
+  if (EFI_ERROR (Status)) {
+    ZeroMem (Region, sizeof (UNDI_DMA_REGION));
+    return Status;
+  }
+
+  DEBUGPRINT (DMA, ("DMA region created. Size: %d, Pages: %d\n",
+    Region->Mapping.Size,
+    EFI_SIZE_TO_PAGES (Region->Mapping.Size)
+    ));
+
+  return EFI_SUCCESS;
+}
+
+/** Unmap and free the DMA region
+
+    @param[in]  PciIo         Pointer to PCI IO protocol installed on controller
+                              handle.
+    @param[in]  Region        Pointer to DMA region structure.
+
+    @retval     EFI_INVALID_PARAMETER   Bad arguments provided.
+    @retval     EFI_ACCESS_DENIED       Buffers carved from the region are still in use.
+    @retval     EFI_SUCCESS             Region freed or was not allocated.
+**/
+EFI_STATUS
+UndiDmaRegionDestroy (
+  EFI_PCI_IO_PROTOCOL       *PciIo,
+  UNDI_DMA_REGION           *Region
+  )
+{
+  EFI_STATUS    Status;
+
+  if (PciIo == NULL || Region == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Region->Mapping.Size == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if (Region->LiveCarves != 0) {
+    DEBUGPRINT (CRITICAL, ("DMA region still has %d buffers in use\n", Region->LiveCarves));
+    return EFI_ACCESS_DENIED;
+  }
+
+  DEBUGPRINT (DMA, ("DMA region destroyed. Pages: %d, Peak used: %d, Fallbacks: %d\n",
+    EFI_SIZE_TO_PAGES (Region->Mapping.Size),
+    Region->PeakUsed,
+    Region->Fallbacks
+    ));
+
+  Status = UndiDmaFreeCommonBuffer (PciIo, &Region->Mapping);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (Region, sizeof (UNDI_DMA_REGION));
+
+  return EFI_SUCCESS;
+}
+
+/** Allocate DMA common buffer from a DMA region
+
+    Falls back to a common buffer of its own when the region is not allocated
+    or has no room left.
+
+    @param[in]  PciIo         Pointer to PCI IO protocol installed on controller
+                              handle.
+    @param[in]  Region        Pointer to DMA region structure.
+    @param[in]  Alignment     Required alignment, power of two up to a page.
+    @param[in]  DmaMapping    Pointer to DMA mapping structure. Size must be filled in.
+
+    @retval     EFI_INVALID_PARAMETER   Bad arguments provided.
+    @retval     EFI_OUT_OF_RESOURCES    Failed to map whole requested area
+    @retval     EFI_SUCCESS             Allocation succeeded.
+**/
+EFI_STATUS
+UndiDmaRegionAllocate (
+  EFI_PCI_IO_PROTOCOL       *PciIo,
+  UNDI_DMA_REGION           *Region,
+  UINTN                     Alignment,
+  UNDI_DMA_MAPPING          *DmaMapping
+  )
+{
+  UINTN         Offset;
+
+  if (PciIo == NULL || Region == NULL || DmaMapping == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (DmaMapping->Size == 0
+    || Alignment == 0
+    || Alignment > EFI_PAGE_SIZE
+    || (Alignment & (Alignment - 1)) != 0)
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Offset = ALIGN_VALUE (Region->Used, Alignment);
+
+  if (Region->Mapping.Size == 0
+    || Offset + DmaMapping->Size > Region->Mapping.Size)
+  {
+    if (Region->Mapping.Size != 0) {
+      DEBUGPRINT (DMA, ("DMA region full, mapping %d bytes on their own\n", DmaMapping->Size));
+      Region->Fallbacks++;
+    }
+
+    DmaMapping->Region = NULL;
+    return UndiDmaAllocateCommonBuffer (PciIo, DmaMapping);
+  }
+
+  DmaMapping->UnmappedAddress = Region->Mapping.UnmappedAddress + Offset;
+  DmaMapping->PhysicalAddress = Region->Mapping.PhysicalAddress + Offset;
+  DmaMapping->Mapping         = NULL;
+  DmaMapping->Region          = Region;
+
+  Region->Used = Offset + DmaMapping->Size;
+  Region->LiveCarves++;
+
+  if (Region->Used > Region->PeakUsed) {
+    Region->PeakUsed = Region->Used;
+  }
+
+  DEBUGPRINT (DMA, ("DMA region carve OK. Offset: %d, Size: %d\n", Offset, DmaMapping->Size));
+
+  return EFI_SUCCESS;
+}
+
+/** Free DMA common buffer allocated with UndiDmaRegionAllocate
+
+    @param[in]  PciIo         Pointer to PCI IO protocol installed on controller
+                              handle.
+    @param[in]  DmaMapping    Pointer to DMA mapping structure (previously
+                              filled by allocation function)
+
+    @retval     EFI_INVALID_PARAMETER   Bad arguments provided.
+    @retval     EFI_SUCCESS             Deallocation succeeded.
+**/
+EFI_STATUS
+UndiDmaRegionFree (
+  EFI_PCI_IO_PROTOCOL       *PciIo,
+  UNDI_DMA_MAPPING          *DmaMapping
+  )
+{
+  UNDI_DMA_REGION *Region;
+
+  if (PciIo == NULL || DmaMapping == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Region = DmaMapping->Region;
+
+  if (Region == NULL) {
+    return UndiDmaFreeCommonBuffer (PciIo, DmaMapping);
+  }
+
+  if (DmaMapping->Size == 0 || Region->LiveCarves == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Region->LiveCarves--;
+
+  // Carving is a bump allocator: space comes back when the last buffer is
+  // returned, or right away for the buffer carved most recently
+  if (Region->LiveCarves == 0) {
+    Region->Used = 0;
+  } else if (DmaMapping->UnmappedAddress + DmaMapping->Size ==
+             Region->Mapping.UnmappedAddress + Region->Used)
+  {
+    Region->Used = (UINTN) (DmaMapping->UnmappedAddress - Region->Mapping.UnmappedAddress);
+  }
+
+  ZeroMem (DmaMapping, sizeof (UNDI_DMA_MAPPING));
+
+  return EFI_SUCCESS;
+}
+
+/** Publish a 16 byte descriptor assembled by the caller
+
+    @param[out] Descriptor    Descriptor in the ring, 16 byte aligned
+    @param[in]  Value         Complete descriptor contents
+**/
+VOID
+UndiDmaDescriptorWrite (
+  VOID                      *Descriptor,
+  CONST VOID                *Value
+  )
+{
+  volatile UINT64 *Destination;
+  CONST UINT64    *Source;
+
+  Destination = (volatile UINT64 *) Descriptor;
+  Source      = (CONST UINT64 *) Value;
+
+  // Two full width stores, no read-modify-write of descriptor memory. The
+  // adapter only fetches it after the tail register write, which is fenced.
+  Destination[0] = Source[0];
+  Destination[1] = Source[1];
+}
+
+/** Snapshot the second quadword of a 16 byte descriptor
+
+    Legacy Rx and Tx descriptors keep everything the adapter writes back,
+    status included, in that quadword.
+
+    @param[in]  Descriptor    Descriptor in the ring, 16 byte aligned
+
+    @return     Quadword as last written by the adapter
+**/
+UINT64
+UndiDmaDescriptorReadWriteBack (
+  CONST VOID                *Descriptor
+  )
+{
+  CONST volatile UINT64 *WriteBack;
+  UINT64                Value;
+
+  WriteBack = (CONST volatile UINT64 *) Descriptor + 1;
+
+#if defined (MDE_CPU_X64) || defined (MDE_CPU_AARCH64)
+  // A single aligned load, cannot mix fields of two write-backs
+  Value = *WriteBack;
+#else /* !MDE_CPU_X64 && !MDE_CPU_AARCH64 */
+  {
+    CONST volatile UINT32 *Half;
+    UINT32                High;
+
+    // Status sits in the upper half, once it reads done the lower half is final
+    Half  = (CONST volatile UINT32 *) WriteBack;
+    High  = Half[1];
+    MemoryFence ();
+    Value = LShiftU64 (High, 32) | Half[0];
+  }
+#endif /* MDE_CPU_X64 || MDE_CPU_AARCH64 */
+
+  // Buffer contents must not be read ahead of the status they belong to
+  MemoryFence ();
+
+  return Value;
+}
@@ -32,14 +32,31 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Uefi.h>
 #include <Protocol/PciIo.h>
 
+// Alignment of sub-allocations carved from a DMA region
+#define UNDI_DMA_CACHE_LINE     64
+#define UNDI_DMA_RING_ALIGN     128
+
+struct _UNDI_DMA_REGION;
+
 // Structure for DMA common buffer mapping
 typedef struct _UNDI_DMA_MAPPING {
   EFI_VIRTUAL_ADDRESS     UnmappedAddress;
   EFI_PHYSICAL_ADDRESS    PhysicalAddress;
   UINTN                   Size;
   VOID                    *Mapping;
+  struct _UNDI_DMA_REGION *Region;        // Region this buffer was carved from, NULL if mapped on its own
 } UNDI_DMA_MAPPING;
 
+// One common buffer mapping per adapter, descriptor rings and buffer pools
+// are carved out of it in allocation order
+typedef struct _UNDI_DMA_REGION {
+  UNDI_DMA_MAPPING        Mapping;        // Whole region, allocated and mapped once
+  UINTN                   Used;           // End of the last carved buffer
+  UINTN                   PeakUsed;       // Highest Used seen during the region lifetime
+  UINTN                   LiveCarves;     // Carved buffers not yet returned
+  UINTN                   Fallbacks;      // Requests that did not fit and were mapped on their own
+} UNDI_DMA_REGION;
+
 /** Allocate DMA common buffer (aligned to the page)
 
     @param[in]  PciIo         Pointer to PCI IO protocol installed on controller
@@ -120,4 +137,103 @@ UndiDmaUnmapMemory (
   UNDI_DMA_MAPPING          *DmaMapping
   );
 
+/** Allocate and map the DMA region sub-allocations are carved from
+
+    @param[in]  PciIo         Pointer to PCI IO protocol installed on controller
+                              handle.
+    @param[in]  Region        Pointer to zeroed DMA region structure.
+    @param[in]  Size          Size of the region in bytes.
+
+    @retval     EFI_INVALID_PARAMETER   Bad arguments provided.
+    @retval     EFI_ALREADY_STARTED     Region is already allocated.
+    @retval     EFI_OUT_OF_RESOURCES    Failed to map whole requested area
+    @retval     EFI_SUCCESS             Allocation succeeded.
+**/
+EFI_STATUS
+UndiDmaRegionCreate (
+  EFI_PCI_IO_PROTOCOL       *PciIo,
+  UNDI_DMA_REGION           *Region,
+  UINTN                     Size
+  );
+
+/** Unmap and free the DMA region
+
+    @param[in]  PciIo         Pointer to PCI IO protocol installed on controller
+                              handle.
+    @param[in]  Region        Pointer to DMA region structure.
+
+    @retval     EFI_INVALID_PARAMETER   Bad arguments provided.
+    @retval     EFI_ACCESS_DENIED       Buffers carved from the region are still in use.
+    @retval     EFI_SUCCESS             Region freed or was not allocated.
+**/
+EFI_STATUS
+UndiDmaRegionDestroy (
+  EFI_PCI_IO_PROTOCOL       *PciIo,
+  UNDI_DMA_REGION           *Region
+  );
+
+/** Allocate DMA common buffer from a DMA region
+
+    Falls back to a common buffer of its own when the region is not allocated
+    or has no room left.
+
+    @param[in]  PciIo         Pointer to PCI IO protocol installed on controller
+                              handle.
+    @param[in]  Region        Pointer to DMA region structure.
+    @param[in]  Alignment     Required alignment, power of two up to a page.
+    @param[in]  DmaMapping    Pointer to DMA mapping structure. Size must be filled in.
+
+    @retval     EFI_INVALID_PARAMETER   Bad arguments provided.
+    @retval     EFI_OUT_OF_RESOURCES    Failed to map whole requested area
+    @retval     EFI_SUCCESS             Allocation succeeded.
+**/
+EFI_STATUS
+UndiDmaRegionAllocate (
+  EFI_PCI_IO_PROTOCOL       *PciIo,
+  UNDI_DMA_REGION           *Region,
+  UINTN                     Alignment,
+  UNDI_DMA_MAPPING          *DmaMapping
+  );
+
+/** Free DMA common buffer allocated with UndiDmaRegionAllocate
+
+    @param[in]  PciIo         Pointer to PCI IO protocol installed on controller
+                              handle.
+    @param[in]  DmaMapping    Pointer to DMA mapping structure (previously
+                              filled by allocation function)
+
+    @retval     EFI_INVALID_PARAMETER   Bad arguments provided.
+    @retval     EFI_SUCCESS             Deallocation succeeded.
+**/
+EFI_STATUS
+UndiDmaRegionFree (
+  EFI_PCI_IO_PROTOCOL       *PciIo,
+  UNDI_DMA_MAPPING          *DmaMapping
+  );
+
+/** Publish a 16 byte descriptor assembled by the caller
+
+    @param[out] Descriptor    Descriptor in the ring, 16 byte aligned
+    @param[in]  Value         Complete descriptor contents
+**/
+VOID
+UndiDmaDescriptorWrite (
+  VOID                      *Descriptor,
+  CONST VOID                *Value
+  );
+
+/** Snapshot the second quadword of a 16 byte descriptor
+
+    Legacy Rx and Tx descriptors keep everything the adapter writes back,
+    status included, in that quadword.
+
+    @param[in]  Descriptor    Descriptor in the ring, 16 byte aligned
+
+    @return     Quadword as last written by the adapter
+**/
+UINT64
+UndiDmaDescriptorReadWriteBack (
+  CONST VOID                *Descriptor
+  );
+
 #endif /* _DMA_H_ */
@@ -35,6 +35,8 @@ EFI_DRIVER_DIAGNOSTICS2_PROTOCOL gGigUndiDriverDiagnostics2;
 
 UINT8 mPacket[MAX_ETHERNET_SIZE];
 
+STATIC EFI_GUID mLoopbackPerfGuid = ADAPTER_INFO_LOOPBACK_PERF_GUID;
+
 /* Forward declaration to compile */
 
 /** This routine is used by diagnostic software to put
@@ -934,6 +936,83 @@ _SetI350MacLoopback (
   MSEC_DELAY (200);   // Add required delay
 }
 
+/** This routine is used to set the MAC of parts without a dedicated
+   MAC loopback sequence into MAC loopback mode.
+
+   @param[in]   Hw   Ptr to this card's HW data structure
+
+   @return   Device put into loopback mode
+**/
+VOID
+_SetMacLoopback (
+  struct e1000_hw *Hw
+  )
+{
+  UINT32 CtrlReg = 0;
+  UINT32 RctlReg = 0;
+
+  DEBUGPRINT (DIAG, ("Setting MAC loopback.\n"));
+
+  // Force 1G full duplex with link up, the PHY is bypassed
+  CtrlReg = E1000_READ_REG (Hw, E1000_CTRL);
+  CtrlReg &= ~(E1000_CTRL_SPD_SEL);
+  CtrlReg |= (E1000_CTRL_SLU      |
+              E1000_CTRL_FRCSPD   |
+              E1000_CTRL_FRCDPX   |
+              E1000_CTRL_SPD_1000 |
+              E1000_CTRL_FD);
+  E1000_WRITE_REG (Hw, E1000_CTRL, CtrlReg);
+
+  RctlReg = E1000_READ_REG (Hw, E1000_RCTL);
+  RctlReg &= ~E1000_RCTL_LBM_MASK;
+  RctlReg |= E1000_RCTL_LBM_MAC;
+  E1000_WRITE_REG (Hw, E1000_RCTL, RctlReg);
+
+  MSEC_DELAY (10);
+}
+
+/** Set the MAC into loopback mode, so frames are returned before they reach the PHY.
+
+   @param[in]   Hw   Pointer to the shared code adapter structure
+
+   @retval   TRUE  MAC has been configured for loopback mode
+   @retval   FALSE MAC loopback is not usable on this adapter
+**/
+BOOLEAN
+E1000SetMacLoopback (
+  struct e1000_hw *Hw
+  )
+{
+  DEBUGPRINT (DIAG, ("E1000SetMacLoopback\n"));
+
+  switch (Hw->mac.type) {
+#ifndef NO_82571_SUPPORT
+  case e1000_82571:
+  case e1000_82572:
+
+    // MAC loopback is broken on I82571 fiber adapters, see E1000SetPhyLoopback
+    if (Hw->phy.media_type != e1000_media_type_copper) {
+      DEBUGPRINT (DIAG, ("MAC loopback not supported on I82571 fiber\n"));
+      return FALSE;
+    }
+    _SetMacLoopback (Hw);
+    break;
+#endif /* NO_82571_SUPPORT */
+  case e1000_i350:
+  case e1000_i210:
+  case e1000_i211:
+    _SetI350MacLoopback (Hw);
+    break;
+  case e1000_i354:
+    _SetI354MacLoopback (Hw);
+    break;
+  default:
+    _SetMacLoopback (Hw);
+    break;
+  }
+
+  return TRUE;
+}
 
 /** Set the PHY into loopback mode.  This routine integrates any errata workarounds that might exist.
 
@@ -1070,6 +1149,17 @@ GigUndiRunPhyLoopback (
   UINT32           i = 0;
   UINT32           j = 0;
 
+  // One receive buffer serves every iteration
+  CpbReceive.BufferAddr = (PXE_UINT64) (UINTN) AllocateZeroPool (RX_BUFFER_SIZE);
+  if (CpbReceive.BufferAddr == (PXE_UINT64) (UINTN) NULL) {
+    DEBUGPRINT (CRITICAL, ("Failed to alloc CpbReceive.BufferAddr\n"));
+    DEBUGWAIT (CRITICAL);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CpbReceive.BufferLen = RX_BUFFER_SIZE;
+  Status = EFI_SUCCESS;
+
   while (j < PHY_LOOPBACK_ITERATIONS) {
     Status = E1000Transmit (
                AdapterInfo,
@@ -1084,16 +1174,6 @@ GigUndiRunPhyLoopback (
     }
 
     // Wait a little, then check to see if the packet has arrived
-    CpbReceive.BufferAddr = (PXE_UINT64) (UINTN) AllocateZeroPool (RX_BUFFER_SIZE);
-    if (CpbReceive.BufferAddr == (PXE_UINT64) (UINTN) NULL) {
-      DEBUGPRINT (CRITICAL, ("Failed to alloc CpbReceive.BufferAddr on iteration %d\n", j));
-      Status = EFI_OUT_OF_RESOURCES;
-      DEBUGWAIT (CRITICAL);
-      break;
-    }
-
-    CpbReceive.BufferLen = RX_BUFFER_SIZE;
-
     for (i = 0; i <= 100000; i++) {
       Status = E1000Receive (
                  AdapterInfo,
@@ -1139,16 +1219,412 @@ GigUndiRunPhyLoopback (
     );
 
     j++;
-    gBS->FreePool ((VOID *) ((UINTN) CpbReceive.BufferAddr));
   }
 
+  gBS->FreePool ((VOID *) ((UINTN) CpbReceive.BufferAddr));
+
+  return Status;
+}
+
+/** Sums a buffer as 32 bit words, rotating the sum by one bit before every add
+   so swapped words are caught too. Trailing bytes are added one by one.
+
+   @param[in]   Buffer   Data to sum
+   @param[in]   Length   Length of Buffer in bytes
+
+   @return   Rotating sum of Buffer
+**/
+STATIC
+UINT32
+_LoopbackPerfSum (
+  IN CONST UINT8 *Buffer,
+  IN UINTN        Length
+  )
+{
+  UINT32 Sum;
+  UINTN  i;
+
+  Sum = 0;
+
+  for (i = 0; i + sizeof (UINT32) <= Length; i += sizeof (UINT32)) {
+    Sum = LRotU32 (Sum, 1) + ReadUnaligned32 ((CONST UINT32 *) (Buffer + i));
+  }
+
+  for (; i < Length; i++) {
+    Sum = LRotU32 (Sum, 1) + Buffer[i];
+  }
+
+  return Sum;
+}
+
+/** Returns the number of performance counter ticks between two counter values,
+   allowing for counters that count down and for a single counter wrap.
+
+   @param[in]   CounterStart   First value of the counter as reported by TimerLib
+   @param[in]   CounterEnd     Last value of the counter as reported by TimerLib
+   @param[in]   From           Earlier counter value
+   @param[in]   To             Later counter value
+
+   @return   Ticks elapsed between From and To
+**/
+STATIC
+UINT64
+_LoopbackPerfTicks (
+  IN UINT64 CounterStart,
+  IN UINT64 CounterEnd,
+  IN UINT64 From,
+  IN UINT64 To
+  )
+{
+  if (CounterEnd >= CounterStart) {
+    return (To >= From) ? (To - From) : ((CounterEnd - From) + (To - CounterStart) + 1);
+  }
+
+  return (From >= To) ? (From - To) : ((From - CounterEnd) + (CounterStart - To) + 1);
+}
+
+/** Finds the latency below which Percent of the samples in the histogram fall.
+
+   @param[in]   Histogram   Latency histogram, LOOPBACK_PERF_BUCKETS entries
+   @param[in]   Samples     Number of samples in the histogram
+   @param[in]   Percent     Requested percentile
+   @param[in]   MaxNs       Largest latency seen, caps the result
+
+   @return   Upper bound of the bucket holding the percentile in nanoseconds
+**/
+STATIC
+UINT32
+_LoopbackPerfPercentile (
+  IN UINT32 *Histogram,
+  IN UINT32  Samples,
+  IN UINT32  Percent,
+  IN UINT32  MaxNs
+  )
+{
+  UINT64 Target;
+  UINT64 Seen;
+  UINTN  i;
+
+  Target  = DivU64x32 (MultU64x32 (Samples, Percent) + 99, 100);
+  Seen    = 0;
+
+  for (i = 0; i < LOOPBACK_PERF_BUCKETS - 1; i++) {
+    Seen += Histogram[i];
+    if (Seen >= Target) {
+      return (UINT32) MIN ((i + 1) * LOOPBACK_PERF_BUCKET_NS, MaxNs);
+    }
+  }
+
+  return MaxNs;
+}
+
+/* Frame sizes (without CRC) cycled through when no frame size is configured */
+STATIC CONST UINT16 mLoopbackPerfSizes[] = {
+  LOOPBACK_PERF_MIN_FRAME_SIZE,
+  590,
+  LOOPBACK_PERF_MAX_FRAME_SIZE
+};
+
+#define LOOPBACK_PERF_SIZE_COUNT  (sizeof (mLoopbackPerfSizes) / sizeof (mLoopbackPerfSizes[0]))
+
+/** Run the loopback performance test. Keeps up to Config->InFlight frames outstanding,
+   checks every frame that comes back against the checksum in its header and records
+   throughput and round trip latency of the intact frames in Result.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure, loopback already set up.
+   @param[in]   Config        Test configuration, zero fields select the defaults.
+   @param[out]  Result        Test counters, throughput and latency.
+
+   @retval   EFI_SUCCESS            All frames came back intact
+   @retval   EFI_OUT_OF_RESOURCES   Not enough memory to allocate test buffers.
+   @retval   EFI_DEVICE_ERROR       Transmit failed, or frames were corrupted or lost
+**/
+EFI_STATUS
+GigUndiRunLoopbackPerf (
+  IN  DRIVER_DATA           *AdapterInfo,
+  IN  LOOPBACK_PERF_CONFIG  *Config,
+  OUT LOOPBACK_PERF_RESULT  *Result
+  )
+{
+  PXE_CPB_TRANSMIT   CpbTransmit;
+  PXE_CPB_RECEIVE    CpbReceive;
+  PXE_DB_RECEIVE     DbReceive;
+  LOOPBACK_PERF_HDR  *Hdr;
+  UINT64             FreeTxBuffer[DEFAULT_TX_DESCRIPTORS];
+  UINT8              *FreeFrames[DEFAULT_TX_DESCRIPTORS];
+  UINT16             Sizes[LOOPBACK_PERF_SIZE_COUNT];
+  UINT32             FillSum[LOOPBACK_PERF_SIZE_COUNT];
+  UINT32             *Histogram;
+  UINT8              *TxPool;
+  UINT8              *RxBuffer;
+  UINT64             CounterStart;
+  UINT64             CounterEnd;
+  UINT64             TimeoutTicks;
+  UINT64             StartTime;
+  UINT64             LastProgress;
+  UINT64             Now;
+  UINT64             Stamp;
+  UINT64             LatencyNs;
+  UINT64             LatencySumNs;
+  UINT64             ElapsedUs;
+  UINT32             FrameCount;
+  UINT32             InFlight;
+  UINT32             SizeCount;
+  UINT32             FreeCount;
+  UINT32             Sequence;
+  UINT32             Outstanding;
+  UINT32             Intact;
+  UINT32             RxSequence;
+  UINT32             Checksum;
+  UINT16             FrameSize;
+  UINT16             Count;
+  BOOLEAN            IsCorrupted;
+  UINTN              i;
+  UINTN              j;
+  EFI_STATUS         Status;
+
+  ZeroMem (Result, sizeof (LOOPBACK_PERF_RESULT));
+
+  FrameCount  = (Config->FrameCount != 0) ? Config->FrameCount : PHY_LOOPBACK_ITERATIONS;
+  InFlight    = (Config->InFlight != 0) ? Config->InFlight : DEFAULT_TX_DESCRIPTORS;
+
+  if (Config->FrameSize != 0) {
+    Sizes[0]  = Config->FrameSize;
+    SizeCount = 1;
+  } else {
+    CopyMem (Sizes, mLoopbackPerfSizes, sizeof (mLoopbackPerfSizes));
+    SizeCount = LOOPBACK_PERF_SIZE_COUNT;
+  }
+
+  TxPool    = AllocateZeroPool (InFlight * LOOPBACK_PERF_FRAME_STRIDE);
+  RxBuffer  = AllocateZeroPool (RX_BUFFER_SIZE);
+  Histogram = AllocateZeroPool (LOOPBACK_PERF_BUCKETS * sizeof (UINT32));
+  if ((TxPool == NULL)
+    || (RxBuffer == NULL)
+    || (Histogram == NULL))
+  {
+    DEBUGPRINT (CRITICAL, ("Failed to allocate loopback performance buffers\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  // Every Tx buffer carries the same addresses and payload pattern, only the
+  // length, sequence number, timestamp and checksum change per frame.
+  for (i = 0; i < InFlight; i++) {
+    Hdr = (LOOPBACK_PERF_HDR *) (TxPool + i * LOOPBACK_PERF_FRAME_STRIDE);
+    CopyMem (Hdr->EthernetHdr.SourceAddr, AdapterInfo->Hw.mac.addr, ETH_ALEN);
+    CopyMem (Hdr->EthernetHdr.DestAddr, AdapterInfo->BroadcastNodeAddress, ETH_ALEN);
+    WriteUnaligned32 (&Hdr->Signature, LOOPBACK_PERF_SIGNATURE);
+    for (j = sizeof (LOOPBACK_PERF_HDR); j < LOOPBACK_PERF_MAX_FRAME_SIZE; j++) {
+      ((UINT8 *) Hdr)[j] = (UINT8) j;
+    }
+    FreeFrames[i] = (UINT8 *) Hdr;
+  }
+  FreeCount = InFlight;
+
+  for (i = 0; i < SizeCount; i++) {
+    FillSum[i] = _LoopbackPerfSum (
+                   TxPool + sizeof (LOOPBACK_PERF_HDR),
+                   Sizes[i] - sizeof (LOOPBACK_PERF_HDR)
+                   );
+  }
+
+  CpbTransmit.MediaheaderLen  = sizeof (ETHERNET_HDR);
+  CpbTransmit.reserved        = 0;
+  CpbReceive.BufferAddr       = (PXE_UINT64) (UINTN) RxBuffer;
+  CpbReceive.BufferLen        = RX_BUFFER_SIZE;
+
+  TimeoutTicks = DivU64x32 (
+                   MultU64x32 (GetPerformanceCounterProperties (&CounterStart, &CounterEnd), LOOPBACK_PERF_TIMEOUT_US),
+                   1000000
+                   );
+
+  Result->LatencyMinNs  = MAX_UINT32;
+  LatencySumNs          = 0;
+  Sequence              = 0;
+  Outstanding           = 0;
+  Status                = EFI_SUCCESS;
+  StartTime             = GetPerformanceCounter ();
+  LastProgress          = StartTime;
+
+  while (Result->FramesReceived < FrameCount) {
+
+    // Keep the Tx ring filled up to the requested depth
+    while ((Sequence < FrameCount)
+      && (Outstanding < InFlight)
+      && (FreeCount > 0))
+    {
+      Hdr       = (LOOPBACK_PERF_HDR *) FreeFrames[FreeCount - 1];
+      FrameSize = Sizes[Sequence % SizeCount];
+
+      Hdr->EthernetHdr.Length[0] = (UINT8) ((FrameSize - sizeof (ETHERNET_HDR)) >> 8);
+      Hdr->EthernetHdr.Length[1] = (UINT8) (FrameSize - sizeof (ETHERNET_HDR));
+
+      Now = GetPerformanceCounter ();
+      WriteUnaligned32 (&Hdr->Sequence, Sequence);
+      WriteUnaligned64 (&Hdr->Timestamp, Now);
+      WriteUnaligned32 (
+        &Hdr->Checksum,
+        FillSum[Sequence % SizeCount] + Sequence + (UINT32) Now + (UINT32) RShiftU64 (Now, 32)
+        );
+
+      CpbTransmit.FrameAddr = (UINT64) (UINTN) Hdr;
+      CpbTransmit.DataLen   = FrameSize - sizeof (ETHERNET_HDR);
+
+      Status = E1000Transmit (AdapterInfo, (UINT64) (UINTN) &CpbTransmit, PXE_OPFLAGS_TRANSMIT_WHOLE);
+      if (Status == PXE_STATCODE_QUEUE_FULL) {
+        Status = EFI_SUCCESS;
+        break;
+      } else if (Status != PXE_STATCODE_SUCCESS) {
+        DEBUGPRINT (CRITICAL, ("E1000Transmit error Status %X. Frame=%d\n", Status, Sequence));
+        Status = EFI_DEVICE_ERROR;
+        break;
+      }
+
+      FreeCount--;
+      Sequence++;
+      Outstanding++;
+      Result->FramesSent++;
+    }
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    // Take back the Tx buffers the hardware is done with
+    Count = (UINT16) E1000FreeTxBuffers (AdapterInfo, DEFAULT_TX_DESCRIPTORS, FreeTxBuffer);
+    for (i = 0; i < Count; i++) {
+      if ((FreeTxBuffer[i] >= (UINTN) TxPool)
+        && (FreeTxBuffer[i] < (UINTN) TxPool + InFlight * LOOPBACK_PERF_FRAME_STRIDE))
+      {
+        FreeFrames[FreeCount++] = (UINT8 *) (UINTN) FreeTxBuffer[i];
+      }
+    }
+
+    // Drain everything looped back so far
+    while (E1000Receive (AdapterInfo, &CpbReceive, &DbReceive) == PXE_STATCODE_SUCCESS) {
+      Now = GetPerformanceCounter ();
+      Hdr = (LOOPBACK_PERF_HDR *) RxBuffer;
+
+      // Packets from NCSI may be received even though loopback is set, skip them
+      if ((DbReceive.FrameLen < sizeof (LOOPBACK_PERF_HDR))
+        || (ReadUnaligned32 (&Hdr->Signature) != LOOPBACK_PERF_SIGNATURE))
+      {
+        continue;
+      }
+
+      LastProgress = Now;
+      Result->FramesReceived++;
+      if (Outstanding > 0) {
+        Outstanding--;
+      }
+
+      // Frame length is taken from the header, the received length
+      // may still include the CRC depending on RCTL.SECRC.
+      RxSequence  = ReadUnaligned32 (&Hdr->Sequence);
+      Stamp       = ReadUnaligned64 (&Hdr->Timestamp);
+      FrameSize   = (UINT16) ((Hdr->EthernetHdr.Length[0] << 8) + Hdr->EthernetHdr.Length[1] + sizeof (ETHERNET_HDR));
+
+      if ((RxSequence >= Sequence)
+        || (FrameSize != Sizes[RxSequence % SizeCount])
+        || (DbReceive.FrameLen < FrameSize)
+        || (DbReceive.FrameLen > FrameSize + LOOPBACK_PERF_CRC_SIZE))
+      {
+        IsCorrupted = TRUE;
+      } else {
+        Checksum  = _LoopbackPerfSum (
+                      RxBuffer + sizeof (LOOPBACK_PERF_HDR),
+                      FrameSize - sizeof (LOOPBACK_PERF_HDR)
+                      );
+        Checksum += RxSequence + (UINT32) Stamp + (UINT32) RShiftU64 (Stamp, 32);
+        IsCorrupted = (BOOLEAN) (Checksum != ReadUnaligned32 (&Hdr->Checksum));
+      }
+
+      if (IsCorrupted) {
+        DEBUGPRINT (CRITICAL, ("ERROR: Frame %d corrupted\n", RxSequence));
+        Result->FramesCorrupted++;
+        continue;
+      }
+
+      Result->BytesReceived += FrameSize;
+
+      LatencyNs = GetTimeInNanoSecond (_LoopbackPerfTicks (CounterStart, CounterEnd, Stamp, Now));
+      if (LatencyNs > MAX_UINT32) {
+        LatencyNs = MAX_UINT32;
+      }
+
+      LatencySumNs += LatencyNs;
+      Result->LatencyMinNs = MIN (Result->LatencyMinNs, (UINT32) LatencyNs);
+      Result->LatencyMaxNs = MAX (Result->LatencyMaxNs, (UINT32) LatencyNs);
+      Histogram[MIN (DivU64x32 (LatencyNs, LOOPBACK_PERF_BUCKET_NS), LOOPBACK_PERF_BUCKETS - 1)]++;
+    }
+
+    if (_LoopbackPerfTicks (CounterStart, CounterEnd, LastProgress, GetPerformanceCounter ()) > TimeoutTicks) {
+      DEBUGPRINT (
+        CRITICAL,
+        ("ERROR: Receive timeout, %d of %d frames returned\n", Result->FramesReceived, Result->FramesSent)
+        );
+      Status = EFI_DEVICE_ERROR;
+      break;
+    }
+  }
+
+  Result->ElapsedNs = GetTimeInNanoSecond (
+                        _LoopbackPerfTicks (CounterStart, CounterEnd, StartTime, GetPerformanceCounter ())
+                        );
+
+  ElapsedUs = DivU64x32 (Result->ElapsedNs, 1000);
+  if (ElapsedUs != 0) {
+    Result->FramesPerSecond = DivU64x64Remainder (MultU64x32 (Result->FramesReceived, 1000000), ElapsedUs, NULL);
+    Result->BytesPerSecond  = DivU64x64Remainder (MultU64x32 (Result->BytesReceived, 1000000), ElapsedUs, NULL);
+  }
+
+  Intact = Result->FramesReceived - Result->FramesCorrupted;
+  if (Intact != 0) {
+    Result->LatencyAvgNs = (UINT32) DivU64x32 (LatencySumNs, Intact);
+    Result->LatencyP50Ns = _LoopbackPerfPercentile (Histogram, Intact, 50, Result->LatencyMaxNs);
+    Result->LatencyP90Ns = _LoopbackPerfPercentile (Histogram, Intact, 90, Result->LatencyMaxNs);
+    Result->LatencyP99Ns = _LoopbackPerfPercentile (Histogram, Intact, 99, Result->LatencyMaxNs);
+  } else {
+    Result->LatencyMinNs = 0;
+  }
+
+  if ((Status == EFI_SUCCESS)
+    && (Result->FramesCorrupted != 0))
+  {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  // Tx buffers may still be owned by the ring after a failure,
+  // give the hardware a bounded time to hand them back before freeing the pool.
+  for (i = 0; (FreeCount < InFlight) && (i < LOOPBACK_PERF_TIMEOUT_US / 10); i++) {
+    Count = (UINT16) E1000FreeTxBuffers (AdapterInfo, DEFAULT_TX_DESCRIPTORS, FreeTxBuffer);
+    FreeCount += Count;
+    gBS->Stall (10);
+  }
+
+Exit:
+  if (TxPool != NULL) {
+    FreePool (TxPool);
+  }
+  if (RxBuffer != NULL) {
+    FreePool (RxBuffer);
+  }
+  if (Histogram != NULL) {
+    FreePool (Histogram);
+  }
+
+  Result->Status = Status;
+
   return Status;
 }
 
 /** Sets up the adapter to run the Phy loopback test and then calls
    the loop which will iterate through the test.
 
-   @param[in]   UndiPrivateData   Driver private data structure
+   @param[in]       UndiPrivateData   Driver private data structure
+   @param[in,out]   LoopbackPerf      When not NULL, run the performance test in the
+                                      loopback mode it selects and store the result in it.
 
    @retval   EFI_SUCCESS                 The PHY loopback test passed.
    @retval   EFI_DEVICE_ERROR            Phy loopback test failed
@@ -1157,7 +1633,8 @@ GigUndiRunPhyLoopback (
 **/
 EFI_STATUS
 GigUndiPhyLoopback (
-  UNDI_PRIVATE_DATA *UndiPrivateData
+  UNDI_PRIVATE_DATA           *UndiPrivateData,
+  ADAPTER_INFO_LOOPBACK_PERF  *LoopbackPerf OPTIONAL
   )
 {
   PXE_CPB_TRANSMIT                      PxeCpbTransmit;
@@ -1165,10 +1642,18 @@ GigUndiPhyLoopback (
   EFI_STATUS                            LoopbackStatus;
   DRIVER_DATA                           *AdapterInfo;
   struct e1000_hw                       *Hw;
+  BOOLEAN                               LoopbackSet;
+  BOOLEAN                               HealthPaused;
 
   AdapterInfo = &UndiPrivateData->NicInfo;
   Hw          = &AdapterInfo->Hw;
 
+  // A failed run must not report the counters of the previous one
+  if (LoopbackPerf != NULL) {
+    ZeroMem (&LoopbackPerf->Result, sizeof (LOOPBACK_PERF_RESULT));
+    LoopbackPerf->Result.Status = EFI_DEVICE_ERROR;
+  }
+
   // Uninstall NII protocol.
   // This should make network stack drivers to stop UNDI (including Tx buffer
   // retrieval).
@@ -1191,6 +1676,9 @@ GigUndiPhyLoopback (
   DEBUGPRINT (DIAG, ("UndiPrivateData->NicInfo.MemIo %X\n", (UINTN) AdapterInfo->MemIo));
   DEBUGWAIT (DIAG);
 
+  // Loopback resets and test traffic are not to be judged by the health monitor
+  HealthPaused = HealthMonitorPause (UndiPrivateData);
+
   // Adapter is stopped at this point. Need to reinitialize it to enable Tx/Rx.
   e1000_reset_hw (Hw);
   AdapterInfo->HwInitialized = FALSE;
@@ -1204,8 +1692,16 @@ GigUndiPhyLoopback (
 
   gBS->Stall (200000);
 
-  // Put the PHY into loopback mode.
-  if (E1000SetPhyLoopback (Hw, SPEED_1000)) {
+  // Put the PHY (or the MAC for the MAC loopback performance test) into loopback mode.
+  if ((LoopbackPerf != NULL)
+    && (LoopbackPerf->Config.LoopbackMode == LOOPBACK_PERF_MODE_MAC))
+  {
+    LoopbackSet = E1000SetMacLoopback (Hw);
+  } else {
+    LoopbackSet = E1000SetPhyLoopback (Hw, SPEED_1000);
+  }
+
+  if (LoopbackSet) {
     DEBUGPRINTWAIT (DIAG, ("PHY loopback mode set successful\n"));
   } else {
     DEBUGPRINTWAIT (CRITICAL, ("ERROR: PHY loopback not set!\n"));
@@ -1224,6 +1720,13 @@ GigUndiPhyLoopback (
     gBS->Stall (1000000);
   }
 
+  if (LoopbackPerf != NULL) {
+    LoopbackStatus = GigUndiRunLoopbackPerf (AdapterInfo, &LoopbackPerf->Config, &LoopbackPerf->Result);
+    DEBUGPRINTWAIT (DIAG, ("Loopback performance test returns %r\n", LoopbackStatus));
+    E1000ReceiveStop (AdapterInfo);
+    goto ExitShutdown;
+  }
+
   // Build our packet, and send it out the door.
   DEBUGPRINT (DIAG, ("Building Packet\n"));
   _BuildPacket (AdapterInfo);
@@ -1251,6 +1754,10 @@ GigUndiPhyLoopback (
   E1000ReceiveStop (AdapterInfo);
 
 ExitShutdown:
+  if (LoopbackPerf != NULL) {
+    LoopbackPerf->Result.Status = LoopbackStatus;
+  }
+
   // After PHY loopback test completes we need to perform a full reset of the adapter.
   // If the adapter was initialized on entry then force a full reset of the adapter.
   // Also reenable the receive unit if it was enabled before we started the PHY loopback test.
@@ -1278,6 +1785,8 @@ ExitShutdown:
   e1000_phy_hw_reset (Hw);
   AdapterInfo->HwInitialized = FALSE;
 
+  HealthMonitorResume (UndiPrivateData, HealthPaused);
+
   DEBUGPRINTWAIT (DIAG, ("Adapter has been reset.\n"));
 
   // Reinstall NII protocol.
@@ -1323,6 +1832,57 @@ Exit:
   return Status;
 }
 
+/** Formats the result of the loopback performance test for the Driver Diagnostics caller.
+
+   @param[in]    LoopbackPerf   Configuration and result of the test
+   @param[out]   BufferSize     Size of the returned string in bytes
+   @param[out]   Buffer         Null-terminated report, allocated from pool
+
+   @retval   EFI_SUCCESS            Report created
+   @retval   EFI_OUT_OF_RESOURCES   Failed to allocate the report
+**/
+STATIC
+EFI_STATUS
+_LoopbackPerfReport (
+  IN  ADAPTER_INFO_LOOPBACK_PERF  *LoopbackPerf,
+  OUT UINTN                       *BufferSize,
+  OUT CHAR16                      **Buffer
+  )
+{
+  LOOPBACK_PERF_RESULT  *Result;
+  UINTN                 Length;
+
+  Result  = &LoopbackPerf->Result;
+  *Buffer = AllocateZeroPool (LOOPBACK_PERF_REPORT_SIZE);
+  if (*Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Length = UnicodeSPrint (
+             *Buffer,
+             LOOPBACK_PERF_REPORT_SIZE,
+             L"%s loopback %r: %d/%d frames, %d corrupted, %ld frames/s, %ld bytes/s, "
+             L"latency ns min %d avg %d p50 %d p90 %d p99 %d max %d",
+             (LoopbackPerf->Config.LoopbackMode == LOOPBACK_PERF_MODE_MAC) ? L"MAC" : L"PHY",
+             Result->Status,
+             Result->FramesReceived,
+             Result->FramesSent,
+             Result->FramesCorrupted,
+             Result->FramesPerSecond,
+             Result->BytesPerSecond,
+             Result->LatencyMinNs,
+             Result->LatencyAvgNs,
+             Result->LatencyP50Ns,
+             Result->LatencyP90Ns,
+             Result->LatencyP99Ns,
+             Result->LatencyMaxNs
+             );
+
+  *BufferSize = (Length + 1) * sizeof (CHAR16);
+
+  return EFI_SUCCESS;
+}
+
 /** Runs diagnostics on a controller.
 
    @param[in]   This   A pointer to the EFI_DRIVER_DIAGNOSTICS_PROTOCOL instance.
@@ -1496,7 +2056,7 @@ GigUndiDriverDiagnosticsRunDiagnostics (
     if (UndiPrivateData->NicInfo.UndiEnabled
       && UndiPrivateData->IsChildInitialized)
     {
-      Status = GigUndiPhyLoopback (UndiPrivateData);
+      Status = GigUndiPhyLoopback (UndiPrivateData, NULL);
       if (EFI_ERROR (Status)) {
         DEBUGPRINT (CRITICAL, ("Driver Diagnostics: GigUndiPhyLoopback error Status %X\n", Status));
         DEBUGWAIT (CRITICAL);
@@ -1506,9 +2066,22 @@ GigUndiDriverDiagnosticsRunDiagnostics (
     }
     break;
   case EfiDriverDiagnosticTypeManufacturing:
-    DEBUGPRINT (CRITICAL, ("Driver Diagnostics: EfiDriverDiagnosticTypeManufacturing not supported\n"));
-    DEBUGWAIT (CRITICAL);
-    Status = EFI_UNSUPPORTED;
+
+    // Loopback performance test, configured and also reported through the Adapter Information Protocol
+    if (UndiPrivateData->NicInfo.UndiEnabled
+      && UndiPrivateData->IsChildInitialized)
+    {
+      Status = GigUndiPhyLoopback (UndiPrivateData, &UndiPrivateData->LoopbackPerf);
+      if (EFI_ERROR (Status)) {
+        DEBUGPRINT (CRITICAL, ("Driver Diagnostics: loopback performance test error Status %X\n", Status));
+        DEBUGWAIT (CRITICAL);
+      }
+      if (!EFI_ERROR (_LoopbackPerfReport (&UndiPrivateData->LoopbackPerf, BufferSize, Buffer))) {
+        *ErrorType = &mLoopbackPerfGuid;
+      }
+    } else {
+      Status = EFI_UNSUPPORTED;
+    }
     break;
   default:
     DEBUGPRINT (CRITICAL, ("Driver Diagnostics: DiagnosticType unsupported!\n"));
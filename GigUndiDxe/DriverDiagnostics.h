@@ -38,6 +38,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define PHY_LOOPBACK_ITERATIONS 10000
 #endif /* (DBG_LVL & DIAG) */
 
+/* Loopback performance test */
+#define LOOPBACK_PERF_SIGNATURE       SIGNATURE_32 ('G', 'L', 'B', 'K')
+#define LOOPBACK_PERF_CRC_SIZE        4
+#define LOOPBACK_PERF_FRAME_STRIDE    1536    // per in-flight Tx buffer, cache line multiple
+#define LOOPBACK_PERF_TIMEOUT_US      1000000 // no frame returned for this long fails the test
+#define LOOPBACK_PERF_BUCKET_NS       1000    // latency histogram resolution
+#define LOOPBACK_PERF_BUCKETS         1024    // last bucket collects everything above
+#define LOOPBACK_PERF_REPORT_SIZE     512     // Driver Diagnostics report buffer, in bytes
+
 #define PHY_PHLBKC              19
 #define PHY_PHCTRL1             23
 #define PHY_PHSTAT              26
@@ -79,6 +88,16 @@ typedef struct {
   UINT8 SourceAddr[6];
   UINT8 Length[2];
 } ETHERNET_HDR;
+
+/* Header of every frame sent by the loopback performance test. Checksum is the
+   rotating sum of the payload that follows it plus Sequence and Timestamp. */
+typedef struct {
+  ETHERNET_HDR  EthernetHdr;
+  UINT32        Signature;
+  UINT32        Sequence;
+  UINT64        Timestamp;
+  UINT32        Checksum;
+} LOOPBACK_PERF_HDR;
 #pragma pack()
 
 #endif /* DRIVER_DIAGNOSTICS_H_ */
@@ -65,7 +65,7 @@ AddHealthError (
 
    @param[in]      UndiPrivateData      Driver private data structure
    @param[out]     DriverHealthStatus   EfiDriverHealthStatusHealthy/Failed, depending if errors are reported
-   @param[in,out]  MessageList          Pointer to pointer of the message list to be returned (only when Unhealthy),
+   @param[in,out]  MessageList          Pointer to pointer of the message list to be returned (when errors or warnings are reported),
                                         NULL on input if MessageList is not requested
 
    @retval   EFI_SUCCESS              Health status retrieved successfully
@@ -111,10 +111,18 @@ GetControllerHealthStatus (
     return EFI_SUCCESS;
   } else {
     DEBUGPRINT (HEALTH, ("Health error count: %d\n", ErrorCount));
-    *DriverHealthStatus = EfiDriverHealthStatusFailed;
     if (ErrorCount > MAX_DRIVER_HEALTH_ERRORS) {
+      *DriverHealthStatus = EfiDriverHealthStatusFailed;
       return EFI_OUT_OF_RESOURCES;
     }
+
+    // Warnings alone leave the controller healthy, the messages are still returned
+    *DriverHealthStatus = EfiDriverHealthStatusHealthy;
+    for (UINT16 MsgIdx = 0; MsgIdx < ErrorCount; MsgIdx++) {
+      if (!mDriverHealthEntry[ErrorIndexes[MsgIdx]].IsWarning) {
+        *DriverHealthStatus = EfiDriverHealthStatusFailed;
+      }
+    }
   }
 
   // Create error message string
@@ -35,8 +35,20 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 typedef struct HEALTH_MSG_ENTRY_S {
   EFI_STRING_ID  StringId;
   CHAR8          *Msg;
+  BOOLEAN        IsWarning;   // reported with the controller still healthy
 } HEALTH_MSG_ENTRY;
 
+/* Periodic link and counter sampling behind GetAdapterHealthStatus() */
+typedef struct {
+  EFI_EVENT            Event;
+  BOOLEAN              Paused;
+  BOOLEAN              LinkKnown;
+  BOOLEAN              LinkUp;
+  UINT32               SamplesSinceLoss;
+  UINT8                Hold[HEALTH_CONDITION_COUNT];
+  ADAPTER_INFO_HEALTH  Info;
+} HEALTH_MONITOR;
+
 typedef struct UNDI_PRIVATE_DATA_S UNDI_PRIVATE_DATA;
 
 /** Helper safe function to add health error (exceeding number will be handled in
@@ -70,4 +82,48 @@ GetAdapterHealthStatus (
   OUT  UINT16             *ErrorIndexes
   );
 
+/** Takes a first health sample and starts periodic sampling of the adapter.
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval  EFI_SUCCESS   Sampling started
+   @retval  !EFI_SUCCESS  Failed to create or arm the sampling timer
+**/
+EFI_STATUS
+HealthMonitorStart (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData
+  );
+
+/** Stops periodic sampling of the adapter.
+
+   @param[in]   UndiPrivateData   Driver private data structure
+**/
+VOID
+HealthMonitorStop (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData
+  );
+
+/** Holds off sampling while the driver itself takes the link down.
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @return   Paused state on entry, to be passed to HealthMonitorResume()
+**/
+BOOLEAN
+HealthMonitorPause (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData
+  );
+
+/** Resumes sampling after HealthMonitorPause(). The link state seen before
+   the pause is dropped, so the driver's own link drop is not a link loss.
+
+   @param[in]   UndiPrivateData   Driver private data structure
+   @param[in]   WasPaused         Value returned by HealthMonitorPause()
+**/
+VOID
+HealthMonitorResume (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData,
+  IN  BOOLEAN            WasPaused
+  );
+
 #endif /* DRIVER_HEALTH_H_ */
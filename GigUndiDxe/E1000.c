@@ -144,7 +144,7 @@ E1000Statistics (
   UINTN                  Stat;
 
   Hw  = &AdapterInfo->Hw;
-  St  = &AdapterInfo->Stats;
+  St  = &AdapterInfo->Cold->Stats;
 
   {
     UPDATE_OR_RESET_STAT (crcerrs, E1000_CRCERRS);
@@ -205,6 +205,18 @@ E1000Statistics (
     UPDATE_OR_RESET_STAT (tsctfc, E1000_TSCTFC);
   }
 
+  RxDropPolicyUpdateCounters (AdapterInfo);
+  RxPriorityRingUpdateCounters (AdapterInfo);
+
+  DEBUGPRINT (
+    E1000, ("Semaphores: %d acquired, %d contended, %d timeouts, %d usec waited, %d usec max\n",
+    Hw->sync.acquisitions,
+    Hw->sync.contended,
+    Hw->sync.timeouts,
+    Hw->sync.wait_usec,
+    Hw->sync.max_wait_usec)
+  );
+
   if (!DbAddr) {
     return PXE_STATCODE_SUCCESS;
   }
@@ -410,13 +422,28 @@ E1000Receive (
   RxBufferSize  = (UINT16) CpbReceive->BufferLen;
   BytesReceived = RxBufferSize;
 
-  Status = ReceiveGetPacket (
+  // Control traffic waiting in the priority queue goes first
+  Status = RxPriorityRingGetPacket (
              AdapterInfo,
              RxBuffer,
              &BytesReceived,
              &PacketLength
              );
 
+  // A bad frame in the priority queue has been recycled already, the main
+  // ring may still hold a good one
+  if ((Status == EFI_NOT_READY)
+    || (Status == EFI_DEVICE_ERROR))
+  {
+    BytesReceived = RxBufferSize;
+    Status = ReceiveGetPacket (
+               AdapterInfo,
+               RxBuffer,
+               &BytesReceived,
+               &PacketLength
+               );
+  }
+
   switch (Status) {
   case EFI_SUCCESS:
     // Packet received successfully
@@ -459,6 +486,15 @@ E1000Receive (
   } else if (BIT_TEST (Header->DestAddr[0], 1)) {
     DEBUGPRINT (RX, ("Multicast packet\n"));
     PacketType = PXE_FRAME_TYPE_MULTICAST;
+
+    // Frames that only matched through hashing or all-multicast are dropped
+    // again by the network stack
+    if (((AdapterInfo->RxFilter & (PXE_OPFLAGS_RECEIVE_FILTER_ALL_MULTICAST | PXE_OPFLAGS_RECEIVE_FILTER_PROMISCUOUS)) == 0)
+      && !AdapterInfo->McastFilter.ForcedAllMulti
+      && !E1000IsMulticastListed (AdapterInfo, Header->DestAddr))
+    {
+      AdapterInfo->McastFilter.SwRejectedFrames++;
+    }
   } else {
     DEBUGPRINT (RX, ("Promiscuous packet\n"));
     PacketType = PXE_FRAME_TYPE_PROMISCUOUS;
@@ -468,6 +504,7 @@ E1000Receive (
   DbReceive->Protocol = Header->Type;
   CopyMem (DbReceive->SrcAddr, Header->SrcAddr, PXE_HWADDR_LEN_ETHER);
   CopyMem (DbReceive->DestAddr, Header->DestAddr, PXE_HWADDR_LEN_ETHER);
+  AdapterInfo->RxDropPolicy.FramesDelivered++;
   StatCode = PXE_STATCODE_SUCCESS;
 
 Exit:
@@ -553,6 +590,9 @@ E1000Shutdown (
     ASSERT_EFI_ERROR (Status);
   }
 
+  // Give the management pass through back to the firmware
+  RxDropPolicyRemove (AdapterInfo);
+
   // Release the software semaphore.
   E1000_WRITE_REG (&AdapterInfo->Hw, E1000_SWSM, 0);
   E1000PciFlush (&AdapterInfo->Hw);
@@ -563,9 +603,508 @@ E1000Shutdown (
 
   AdapterInfo->RxFilter = 0;
 
+  // Keep the rings for a moment in case the port is initialized again right away
+  E1000RingsLinger (AdapterInfo);
+
   return PXE_STATCODE_SUCCESS;
 }
 
+/** Checks whether the MAC has per queue enable bits in RXDCTL and TXDCTL.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @retval   TRUE    Queue enable bits present
+   @retval   FALSE   Queues follow RCTL.EN and TCTL.EN only
+**/
+STATIC
+BOOLEAN
+E1000HasQueueEnable (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  switch (AdapterInfo->Hw.mac.type) {
+#ifndef NO_82575_SUPPORT
+  case e1000_82575:
+#ifndef NO_82576_SUPPORT
+  case e1000_82576:
+#endif /* !NO_82576_SUPPORT */
+#ifndef NO_82580_SUPPORT
+  case e1000_82580:
+#endif /* !NO_82580_SUPPORT */
+  case e1000_i350:
+  case e1000_i354:
+#ifndef NO_I210_SUPPORT
+  case e1000_i210:
+  case e1000_i211:
+#endif /* !NO_I210_SUPPORT */
+    return TRUE;
+#endif /* !NO_82575_SUPPORT */
+  default:
+    return FALSE;
+  }
+}
+
+/** First phase of a quiesce, requests the adapter to stop all DMA without waiting.
+
+   Disables the Tx and Rx queues, gives the management pass through back to
+   the firmware and blocks new bus master requests. Meant for the
+   ExitBootServices path, where memory services are no longer available.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @return   DMA stop requested
+**/
+VOID
+E1000QuiesceStart (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  DEBUGPRINT (E1000, ("E1000QuiesceStart\n"));
+
+  if (E1000HasQueueEnable (AdapterInfo)) {
+    E1000ClearRegBits (AdapterInfo, E1000_RXDCTL (0), E1000_RXDCTL_QUEUE_ENABLE);
+    E1000ClearRegBits (AdapterInfo, E1000_TXDCTL (0), E1000_TXDCTL_QUEUE_ENABLE);
+    if (AdapterInfo->PriorityRxRing.IsRunning) {
+      E1000ClearRegBits (AdapterInfo, E1000_RXDCTL (RX_PRIORITY_QUEUE), E1000_RXDCTL_QUEUE_ENABLE);
+    }
+  }
+
+  E1000ClearRegBits (AdapterInfo, E1000_RCTL, E1000_RCTL_EN);
+  E1000ClearRegBits (AdapterInfo, E1000_TCTL, E1000_TCTL_EN);
+
+  AdapterInfo->PriorityRxRing.IsRunning = FALSE;
+  AdapterInfo->RxRing.IsRunning         = FALSE;
+  AdapterInfo->TxRing.IsRunning         = FALSE;
+
+  // Give the management pass through back to the firmware
+  RxDropPolicyRemove (AdapterInfo);
+
+  // Release the software semaphore.
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_SWSM, 0);
+
+  // Requests already on the bus complete, new ones are blocked. The OS driver
+  // lifts this with its first device reset.
+  if (AdapterInfo->Hw.bus.type == e1000_bus_type_pci_express) {
+    E1000SetRegBits (AdapterInfo, E1000_CTRL, E1000_CTRL_GIO_MASTER_DISABLE);
+  }
+
+  E1000PciFlush (&AdapterInfo->Hw);
+
+  AdapterInfo->RxFilter = 0;
+}
+
+/** Second phase of a quiesce, checks whether the adapter stopped all DMA.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @retval   TRUE    Queues are disabled and no bus master request is pending
+   @retval   FALSE   Adapter is still busy
+**/
+BOOLEAN
+E1000QuiesceDone (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  if (E1000HasQueueEnable (AdapterInfo)) {
+    if (BIT_TEST (E1000_READ_REG (&AdapterInfo->Hw, E1000_RXDCTL (0)), E1000_RXDCTL_QUEUE_ENABLE)
+      || BIT_TEST (E1000_READ_REG (&AdapterInfo->Hw, E1000_TXDCTL (0)), E1000_TXDCTL_QUEUE_ENABLE))
+    {
+      return FALSE;
+    }
+
+    // The priority queue keeps fetching descriptors until its own enable bit clears
+    if (RxPriorityRingSupported (AdapterInfo)
+      && BIT_TEST (E1000_READ_REG (&AdapterInfo->Hw, E1000_RXDCTL (RX_PRIORITY_QUEUE)), E1000_RXDCTL_QUEUE_ENABLE))
+    {
+      return FALSE;
+    }
+  }
+
+  if (AdapterInfo->Hw.bus.type == e1000_bus_type_pci_express) {
+    return !BIT_TEST (E1000_READ_REG (&AdapterInfo->Hw, E1000_STATUS), E1000_STATUS_GIO_MASTER_ENABLE);
+  }
+
+  return TRUE;
+}
+
+/** Builds the name of a per-port variable. The permanent MAC address keeps
+   the setting with the port across slot changes.
+
+   @param[in]    AdapterInfo   Pointer to the driver structure
+   @param[in]    Prefix        Name of the setting
+   @param[out]   Name          Buffer for the variable name
+   @param[in]    NameSize      Size of Name in bytes
+
+   @return   Name filled in
+**/
+STATIC
+VOID
+E1000PortVariableName (
+  IN  DRIVER_DATA *AdapterInfo,
+  IN  CHAR16      *Prefix,
+  OUT CHAR16      *Name,
+  IN  UINTN        NameSize
+  )
+{
+  UINT8 *Mac;
+
+  Mac = AdapterInfo->Hw.mac.perm_addr;
+  UnicodeSPrint (
+    Name,
+    NameSize,
+    L"%s%02x%02x%02x%02x%02x%02x",
+    Prefix,
+    Mac[0], Mac[1], Mac[2], Mac[3], Mac[4], Mac[5]
+  );
+}
+
+/** Reads a one byte per-port setting.
+
+   @param[in]    AdapterInfo   Pointer to the driver structure
+   @param[in]    Prefix        Name of the setting
+   @param[out]   Value         Stored value
+
+   @retval   EFI_SUCCESS    Value read
+   @retval   !EFI_SUCCESS   Nothing stored or failed to read the variable
+**/
+EFI_STATUS
+E1000PortVariableGet (
+  IN  DRIVER_DATA *AdapterInfo,
+  IN  CHAR16      *Prefix,
+  OUT UINT8       *Value
+  )
+{
+  CHAR16 Name[PORT_VARIABLE_NAME_LENGTH];
+  UINTN  Size;
+
+  E1000PortVariableName (AdapterInfo, Prefix, Name, sizeof (Name));
+
+  Size = sizeof (*Value);
+  return gRT->GetVariable (Name, &gEfiCallerIdGuid, NULL, &Size, Value);
+}
+
+/** Stores a one byte per-port setting in a non-volatile variable.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+   @param[in]   Prefix        Name of the setting
+   @param[in]   Value         Value to store
+
+   @retval   EFI_SUCCESS    Value stored
+   @retval   !EFI_SUCCESS   Failed to write the variable
+**/
+EFI_STATUS
+E1000PortVariableSet (
+  IN DRIVER_DATA *AdapterInfo,
+  IN CHAR16      *Prefix,
+  IN UINT8        Value
+  )
+{
+  CHAR16 Name[PORT_VARIABLE_NAME_LENGTH];
+
+  E1000PortVariableName (AdapterInfo, Prefix, Name, sizeof (Name));
+
+  return gRT->SetVariable (
+                Name,
+                &gEfiCallerIdGuid,
+                EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                sizeof (Value),
+                &Value
+                );
+}
+
+/** Reads the persisted packet buffer profile of the port.
+
+   Falls back to PACKET_BUFFER_PROFILE_STANDARD when nothing was stored yet.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @return   AdapterInfo->PacketBufferProfile initialized
+**/
+VOID
+E1000PacketBufferProfileLoad (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  UINT8      Profile;
+  EFI_STATUS Status;
+
+  Status = E1000PortVariableGet (AdapterInfo, PACKET_BUFFER_PROFILE_VARIABLE_NAME, &Profile);
+  if (EFI_ERROR (Status)
+    || (Profile > PACKET_BUFFER_PROFILE_RX))
+  {
+    Profile = PACKET_BUFFER_PROFILE_STANDARD;
+  }
+
+  AdapterInfo->PacketBufferProfile = Profile;
+  DEBUGPRINT (INIT, ("Packet buffer profile %d\n", Profile));
+}
+
+/** Persists the packet buffer profile of the port.
+
+   The profile is programmed by the next full reset of the port.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+   @param[in]   Profile       PACKET_BUFFER_PROFILE_* value
+
+   @retval   EFI_SUCCESS             Profile stored
+   @retval   EFI_INVALID_PARAMETER   Unknown profile
+   @retval   EFI_UNSUPPORTED         Receive optimized profile not supported by the MAC
+   @retval   !EFI_SUCCESS            Failed to store the profile
+**/
+EFI_STATUS
+E1000PacketBufferProfileSet (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT8        Profile
+  )
+{
+  EFI_STATUS Status;
+
+  if (Profile > PACKET_BUFFER_PROFILE_RX) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((Profile == PACKET_BUFFER_PROFILE_RX)
+    && !E1000PacketBufferProfileSupported (AdapterInfo))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Profile == AdapterInfo->PacketBufferProfile) {
+    return EFI_SUCCESS;
+  }
+
+  Status = E1000PortVariableSet (AdapterInfo, PACKET_BUFFER_PROFILE_VARIABLE_NAME, Profile);
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("Failed to store packet buffer profile: %r\n", Status));
+    return Status;
+  }
+
+  AdapterInfo->PacketBufferProfile = Profile;
+
+  return EFI_SUCCESS;
+}
+
+/** Tells whether the receive optimized packet buffer profile has an effect
+   on the port, that is whether E1000PacketBufferSplit can move space from
+   transmit to receive on its MAC.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @retval   TRUE    Receive optimized profile supported
+   @retval   FALSE   Only the standard profile applies
+**/
+BOOLEAN
+E1000PacketBufferProfileSupported (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  switch (AdapterInfo->Hw.mac.type) {
+#ifndef NO_82571_SUPPORT
+  case e1000_82571:
+  case e1000_82572:
+  case e1000_82573:
+#ifndef NO_82574_SUPPORT
+  case e1000_82574:
+  case e1000_82583:
+#endif /* !NO_82574_SUPPORT */
+#endif /* !NO_82571_SUPPORT */
+#ifndef NO_80003ES2LAN_SUPPORT
+  case e1000_80003es2lan:
+#endif /* !NO_80003ES2LAN_SUPPORT */
+#ifndef NO_82575_SUPPORT
+  case e1000_82575:
+#ifndef NO_I210_SUPPORT
+  case e1000_i210:
+  case e1000_i211:
+#endif /* !NO_I210_SUPPORT */
+#endif /* !NO_82575_SUPPORT */
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+/** Reads the receive packet buffer allocation of the port.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @return   Receive packet buffer size in KB
+**/
+STATIC
+UINT32
+E1000PacketBufferRxSize (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  struct e1000_hw *Hw;
+
+  Hw = &AdapterInfo->Hw;
+
+  switch (Hw->mac.type) {
+#ifndef NO_82575_SUPPORT
+  case e1000_82576:
+    return E1000_READ_REG (Hw, E1000_RXPBS) & E1000_RXPBS_SIZE_MASK_82576;
+#ifndef NO_82580_SUPPORT
+  case e1000_82580:
+  case e1000_i350:
+  case e1000_i354:
+    return e1000_rxpbs_adjust_82580 (E1000_READ_REG (Hw, E1000_RXPBS));
+#endif /* !NO_82580_SUPPORT */
+#ifndef NO_I210_SUPPORT
+  case e1000_i210:
+  case e1000_i211:
+    return E1000_READ_REG (Hw, E1000_RXPBS) & E1000_RXPBS_SIZE_I210_MASK;
+#endif /* !NO_I210_SUPPORT */
+#endif /* !NO_82575_SUPPORT */
+  default:
+    return E1000_READ_REG (Hw, E1000_PBA) & E1000_PBA_RXA_MASK;
+  }
+}
+
+/** Moves packet buffer space from transmit to receive, leaving
+   PACKET_BUFFER_TX_KB for transmit, when the port uses PACKET_BUFFER_PROFILE_RX.
+   The total is kept, so the split can be read back and applied again before
+   every reset.
+
+   The registers only take effect with the next MAC reset, so this must be
+   called right before e1000_reset_hw.
+
+   82576 has separate Rx and Tx buffers, 82580 and I350 parts use encoded
+   sizes with a fixed total and ICH/PCH parts keep the split their reset
+   code programs, these are left as they are.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @retval   TRUE    Split written, a MAC reset is needed to apply it
+   @retval   FALSE   Split left as it is
+**/
+STATIC
+BOOLEAN
+E1000PacketBufferSplit (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  struct e1000_hw *Hw;
+  UINT32           Pba;
+  UINT32           Rxpbs;
+  UINT32           Txpbs;
+  UINT32           RxKb;
+  UINT32           TxKb;
+  UINT32           MoveKb;
+
+  Hw = &AdapterInfo->Hw;
+
+  if (AdapterInfo->PacketBufferProfile != PACKET_BUFFER_PROFILE_RX) {
+    return FALSE;
+  }
+
+  switch (Hw->mac.type) {
+#ifndef NO_82571_SUPPORT
+  case e1000_82571:
+  case e1000_82572:
+  case e1000_82573:
+#ifndef NO_82574_SUPPORT
+  case e1000_82574:
+  case e1000_82583:
+#endif /* !NO_82574_SUPPORT */
+#endif /* !NO_82571_SUPPORT */
+#ifndef NO_80003ES2LAN_SUPPORT
+  case e1000_80003es2lan:
+#endif /* !NO_80003ES2LAN_SUPPORT */
+#ifndef NO_82575_SUPPORT
+  case e1000_82575:
+#endif /* !NO_82575_SUPPORT */
+    // Only the Rx allocation is written, the Tx remainder reads back in the upper word
+    Pba  = E1000_READ_REG (Hw, E1000_PBA);
+    RxKb = Pba & E1000_PBA_RXA_MASK;
+    TxKb = Pba >> 16;
+    if (TxKb > PACKET_BUFFER_TX_KB) {
+      E1000_WRITE_REG (Hw, E1000_PBA, RxKb + TxKb - PACKET_BUFFER_TX_KB);
+      return TRUE;
+    }
+    break;
+#ifndef NO_82575_SUPPORT
+#ifndef NO_I210_SUPPORT
+  case e1000_i210:
+  case e1000_i211:
+    Rxpbs = E1000_READ_REG (Hw, E1000_RXPBS);
+    Txpbs = E1000_READ_REG (Hw, E1000_TXPBS);
+    RxKb  = Rxpbs & E1000_RXPBS_SIZE_I210_MASK;
+    TxKb  = Txpbs & E1000_TXPBS_SIZE_I210_MASK;
+    if (TxKb <= PACKET_BUFFER_TX_KB) {
+      break;
+    }
+
+    // Tx shrinks first so the sum of both never exceeds the buffer
+    MoveKb = MIN (TxKb - PACKET_BUFFER_TX_KB, E1000_RXPBS_SIZE_I210_MASK - RxKb);
+    E1000_WRITE_REG (Hw, E1000_TXPBS, (Txpbs & ~E1000_TXPBS_SIZE_I210_MASK) | (TxKb - MoveKb));
+    E1000_WRITE_REG (Hw, E1000_RXPBS, (Rxpbs & ~E1000_RXPBS_SIZE_I210_MASK) | (RxKb + MoveKb));
+    return TRUE;
+#endif /* !NO_I210_SUPPORT */
+#endif /* !NO_82575_SUPPORT */
+  default:
+    break;
+  }
+
+  return FALSE;
+}
+
+/** Sets up the flow control thresholds according to the packet buffer
+   profile of the port and the packet buffer split in effect.
+
+   Must be called after the MAC reset that applied the split and before
+   e1000_init_hw, which writes the thresholds.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @return   Hw.fc set up
+**/
+VOID
+E1000PacketBufferSetup (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  struct e1000_hw *Hw;
+  UINT32           RxBytes;
+  UINT32           HighWater;
+
+  Hw = &AdapterInfo->Hw;
+
+  // Standard leaves the split and the thresholds as the shared code sets them
+  Hw->fc.high_water   = 0;
+  Hw->fc.low_water    = 0;
+  Hw->fc.pause_time   = 0;
+  Hw->fc.refresh_time = 0;
+  Hw->fc.send_xon     = FALSE;
+
+  if ((AdapterInfo->PacketBufferProfile != PACKET_BUFFER_PROFILE_RX)
+    || !E1000PacketBufferProfileSupported (AdapterInfo))
+  {
+    return;
+  }
+
+  // XOFF goes out while two more full frames still fit, as the OS drivers do it
+  RxBytes = E1000PacketBufferRxSize (AdapterInfo) << 10;
+  if (RxBytes <= 4 * PACKET_BUFFER_MAX_FRAME) {
+    DEBUGPRINT (CRITICAL, ("Rx packet buffer of %d bytes too small for flow control\n", RxBytes));
+    return;
+  }
+
+  HighWater = MIN (RxBytes * 9 / 10, RxBytes - 2 * PACKET_BUFFER_MAX_FRAME);
+  HighWater = MIN (HighWater, PACKET_BUFFER_WATER_MASK);
+
+  Hw->fc.requested_mode = e1000_fc_full;
+  Hw->fc.high_water     = HighWater & PACKET_BUFFER_WATER_MASK;
+  Hw->fc.low_water      = Hw->fc.high_water - 16;
+  Hw->fc.send_xon       = TRUE;
+  Hw->fc.pause_time     = 0xFFFF;
+
+  DEBUGPRINT (
+    INIT,
+    ("Rx packet buffer %d bytes, XOFF at %x, XON at %x\n", RxBytes, Hw->fc.high_water, Hw->fc.low_water)
+  );
+}
+
 /** Resets the hardware and put it all (including the PHY) into a known good state.
 
    @param[in]   AdapterInfo   The pointer to our context data
@@ -580,7 +1119,9 @@ E1000Reset (
   IN UINT16       OpFlags
   )
 {
-  UINT32 TempReg;
+  UINT32  TempReg;
+  BOOLEAN HealthPaused;
+  UINT32  ScStatus;
 
   DEBUGPRINT (E1000, ("E1000Reset\n"));
 
@@ -607,10 +1148,18 @@ E1000Reset (
   // We want to make sure we do not have to restart autonegotiation and two-pair
   // downshift.
   if (!AdapterInfo->HwInitialized) {
+    HealthPaused = HealthMonitorPause (UNDI_PRIVATE_DATA_FROM_DRIVER_DATA (AdapterInfo));
+
+    E1000PacketBufferSplit (AdapterInfo);
     e1000_reset_hw (&AdapterInfo->Hw);
+    E1000PacketBufferSetup (AdapterInfo);
+    E1000InvalidateMulticastFilters (AdapterInfo);
+    RxVlanFilterInvalidate (AdapterInfo);
 
     // Now that the structures are in place, we can configure the hardware to use it all.
-    if (e1000_init_hw (&AdapterInfo->Hw) == 0) {
+    ScStatus = e1000_init_hw (&AdapterInfo->Hw);
+    HealthMonitorResume (UNDI_PRIVATE_DATA_FROM_DRIVER_DATA (AdapterInfo), HealthPaused);
+    if (ScStatus == E1000_SUCCESS) {
       DEBUGPRINT (E1000, ("e1000_init_hw success\n"));
     } else {
       DEBUGPRINT (CRITICAL, ("Hardware Init failed\n"));
@@ -841,6 +1390,14 @@ E1000TxRxConfigure (
 ExitStartTx:
   Status = TransmitStart (AdapterInfo);
   ASSERT_EFI_ERROR (Status);
+
+  // Filters have to be in place before the first frame is accepted. The VLAN
+  // set is read again here, this also drops VLANs removed since.
+  AdapterInfo->VlanFilter.SetStale = TRUE;
+  RxVlanFilterRefresh (AdapterInfo);
+  RxVlanFilterUpdate (AdapterInfo);
+  RxDropPolicyRemove (AdapterInfo);
+  RxDropPolicyApply (AdapterInfo);
 ExitStartRx:
   Status = ReceiveStart (AdapterInfo);
   ASSERT_EFI_ERROR (Status);
@@ -958,10 +1515,10 @@ E1000FirstTimeInit (
                            EfiPciIoWidthUint32,
                            0,
                            MAX_PCI_CONFIG_LEN,
-                           AdapterInfo->PciConfig
+                           AdapterInfo->Cold->PciConfig
                          );
 
-  PciConfigHeader = (PCI_CONFIG_HEADER *) AdapterInfo->PciConfig;
+  PciConfigHeader = (PCI_CONFIG_HEADER *) AdapterInfo->Cold->PciConfig;
 
   // Enumerate through the PCI BARs for the device to determine which one is
   // the IO BAR.  Save the index of the BAR into the adapter info structure.
@@ -1071,6 +1628,8 @@ E1000FirstTimeInit (
   }
   DEBUGPRINT (INIT, ("\n"));
 
+  E1000PacketBufferProfileLoad (AdapterInfo);
+
   Reg = E1000_READ_REG (&AdapterInfo->Hw, E1000_CTRL_EXT);
   if ((Reg & E1000_CTRL_EXT_DRV_LOAD) != 0) {
     DEBUGPRINT (CRITICAL, ("iSCSI Boot detected on port!\n"));
@@ -1078,11 +1637,15 @@ E1000FirstTimeInit (
   }
 
 
+  E1000PacketBufferSplit (AdapterInfo);
   ScStatus = e1000_reset_hw (&AdapterInfo->Hw);
   if (ScStatus != E1000_SUCCESS) {
     DEBUGPRINT (CRITICAL, ("e1000_reset_hw returns %d\n", ScStatus));
     return EFI_DEVICE_ERROR;
   }
+  E1000PacketBufferSetup (AdapterInfo);
+  E1000InvalidateMulticastFilters (AdapterInfo);
+  RxVlanFilterInvalidate (AdapterInfo);
 
   // Now that the structures are in place, we can configure the hardware to use it all.
   ScStatus = e1000_init_hw (&AdapterInfo->Hw);
@@ -1119,35 +1682,387 @@ E1000FirstTimeInit (
   return Status;
 }
 
-/** Initializes the gigabit adapter, setting up memory addresses, MAC Addresses,
-   Type of card, etc.
+/** Returns the number of Rx descriptors to allocate for a request.
 
-   @param[in]   AdapterInfo   Pointer to adapter structure
+   @param[in]   Requested   Count asked for by the protocol driver, 0 for default
 
-   @retval   PXE_STATCODE_SUCCESS       Initialization succeeded
-   @retval   PXE_STATCODE_NOT_STARTED   Hardware Init failed
+   @return   Ring size between MIN_RX_DESCRIPTORS and DEFAULT_RX_DESCRIPTORS
 **/
-PXE_STATCODE
-E1000Inititialize (
-  IN DRIVER_DATA *AdapterInfo
+STATIC
+UINT16
+E1000RxRingSize (
+  IN UINT16 Requested
   )
 {
-  PXE_STATCODE PxeStatcode = PXE_STATCODE_SUCCESS;
+  if ((Requested == 0)
+    || (Requested >= DEFAULT_RX_DESCRIPTORS))
+  {
+    return DEFAULT_RX_DESCRIPTORS;
+  }
 
-  DEBUGPRINT (E1000, ("E1000Inititialize\n"));
+  if (Requested < MIN_RX_DESCRIPTORS) {
+    return MIN_RX_DESCRIPTORS;
+  }
 
+  return (UINT16) (Requested & ~(RING_DESCRIPTOR_ALIGN - 1));
+}
 
-  DEBUGWAIT (E1000);
+/** Returns the size of the DMA region holding all rings of the adapter.
 
-  E1000SetSpeedDuplex (AdapterInfo);
+   Follows the order and alignment the rings are carved in by E1000RingsAcquire,
+   Rx descriptors directly precede the Rx buffers they point to.
 
-  // If the hardware has already been initialized then don't bother with a reset
-  // We want to make sure we do not have to restart autonegotiation and two-pair
-  // downshift.
-  if (!AdapterInfo->HwInitialized) {
-    DEBUGPRINT (E1000, ("Initializing hardware!\n"));
+   @param[in]   AdapterInfo   Pointer to adapter structure
+   @param[in]   RxCount       Number of Rx descriptors
 
-    if (e1000_init_hw (&AdapterInfo->Hw) == 0) {
+   @return   Region size in bytes
+**/
+STATIC
+UINTN
+E1000RingsRegionSize (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT16       RxCount
+  )
+{
+  UINTN Size;
+
+  Size = ALIGN_VALUE (DEFAULT_TX_DESCRIPTORS * sizeof (TRANSMIT_DESCRIPTOR), UNDI_DMA_RING_ALIGN);
+
+  if (RxPriorityRingSupported (AdapterInfo)) {
+    Size += ALIGN_VALUE (RX_PRIORITY_DESCRIPTORS * sizeof (RECEIVE_DESCRIPTOR), UNDI_DMA_RING_ALIGN);
+    Size += ALIGN_VALUE (RX_PRIORITY_DESCRIPTORS * RX_BUFFER_SIZE, UNDI_DMA_RING_ALIGN);
+  }
+
+  Size += ALIGN_VALUE (RxCount * sizeof (RECEIVE_DESCRIPTOR), UNDI_DMA_RING_ALIGN);
+  Size += RxCount * RX_BUFFER_SIZE;
+
+  return Size;
+}
+
+/** Returns the pages taken by a DMA buffer that has a mapping of its own.
+
+   @param[in]   DmaMapping   Pointer to DMA mapping structure
+
+   @return   Number of pages, 0 for buffers carved from the DMA region
+**/
+STATIC
+UINTN
+E1000DmaPages (
+  IN UNDI_DMA_MAPPING *DmaMapping
+  )
+{
+  if (DmaMapping->Region != NULL) {
+    return 0;
+  }
+
+  return EFI_SIZE_TO_PAGES (DmaMapping->Size);
+}
+
+/** Returns the DMA memory currently held by the rings of the adapter.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @return   Size in bytes of the DMA region and of rings mapped on their own
+**/
+STATIC
+UINTN
+E1000RingsFootprint (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  return EFI_PAGES_TO_SIZE (
+           E1000DmaPages (&AdapterInfo->DmaRegion.Mapping)
+           + E1000DmaPages (&AdapterInfo->TxRing.Descriptors)
+           + E1000DmaPages (&AdapterInfo->RxRing.Descriptors)
+           + E1000DmaPages (&AdapterInfo->RxRing.Buffers)
+           + E1000DmaPages (&AdapterInfo->PriorityRxRing.Descriptors)
+           + E1000DmaPages (&AdapterInfo->PriorityRxRing.Buffers)
+           );
+}
+
+/** Frees whichever of the Tx and Rx rings are allocated.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @retval   EFI_SUCCESS   Rings freed or were not allocated
+   @retval   Others        Tx or Rx ring cleanup failed
+**/
+STATIC
+EFI_STATUS
+E1000RingsFree (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Footprint;
+
+  // Memory services must not be used once ExitBootServices has started
+  if (mExitBootServicesTriggered) {
+    return EFI_SUCCESS;
+  }
+
+  Footprint = E1000RingsFootprint (AdapterInfo);
+
+  // Rx holds almost all of the memory, release it even if Tx buffers are still
+  // owned by the protocol driver
+  if (IS_RX_RING_INITIALIZED (&AdapterInfo->RxRing)) {
+    Status = ReceiveCleanup (AdapterInfo);
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("ReceiveCleanup returned %r\n", Status));
+      return Status;
+    }
+  }
+
+  RxPriorityRingCleanup (AdapterInfo);
+
+  if (IS_TX_RING_INITIALIZED (&AdapterInfo->TxRing)) {
+    Status = TransmitCleanup (AdapterInfo);
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("TransmitCleanup returned %r\n", Status));
+      return Status;
+    }
+  }
+
+  Status = UndiDmaRegionDestroy (PCI_IO_FROM_ADAPTER (AdapterInfo), &AdapterInfo->DmaRegion);
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("UndiDmaRegionDestroy returned %r\n", Status));
+    return Status;
+  }
+
+  if (Footprint != 0) {
+    DEBUGPRINT (INIT, ("Released %d bytes of ring DMA memory\n", Footprint));
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Timer notification freeing the rings of an adapter that stayed shut down.
+
+   @param[in]   Event     Linger timer event
+   @param[in]   Context   Pointer to adapter structure
+
+   @return   Rings freed unless the adapter was initialized again
+**/
+STATIC
+VOID
+EFIAPI
+E1000RingsLingerExpired (
+  IN EFI_EVENT Event,
+  IN VOID      *Context
+  )
+{
+  DRIVER_DATA *AdapterInfo;
+
+  AdapterInfo = (DRIVER_DATA *) Context;
+
+  if ((AdapterInfo->State == PXE_STATFLAGS_GET_STATE_INITIALIZED)
+    || AdapterInfo->RxRing.IsRunning
+    || AdapterInfo->TxRing.IsRunning)
+  {
+    return;
+  }
+
+  E1000RingsFree (AdapterInfo);
+}
+
+/** Makes sure the Tx and Rx rings are allocated before the port carries traffic.
+
+   Rings still lingering from the previous Shutdown are reused when their size
+   matches the current request, otherwise they are replaced.
+   Rings that are running are never reallocated.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @retval   EFI_SUCCESS   Rings are allocated and handed to the hardware
+   @retval   Others        Allocation of one of the rings failed
+**/
+EFI_STATUS
+E1000RingsAcquire (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+  UINT16      RxCount;
+
+  RxCount = E1000RxRingSize (AdapterInfo->RxRingRequest);
+  Status  = EFI_SUCCESS;
+
+  // Keep the linger timer from freeing the rings while they are taken back
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  if (AdapterInfo->RingLingerEvent != NULL) {
+    gBS->SetTimer (AdapterInfo->RingLingerEvent, TimerCancel, 0);
+  }
+
+  // The region is sized for one Rx ring size, a different one starts over
+  if (IS_RX_RING_INITIALIZED (&AdapterInfo->RxRing)
+    && !AdapterInfo->RxRing.IsRunning
+    && !AdapterInfo->TxRing.IsRunning
+    && (AdapterInfo->RxRing.BufferCount != RxCount))
+  {
+    Status = E1000RingsFree (AdapterInfo);
+    if (EFI_ERROR (Status)) {
+      goto Exit;
+    }
+  }
+
+  if ((AdapterInfo->DmaRegion.Mapping.Size == 0)
+    && !IS_TX_RING_INITIALIZED (&AdapterInfo->TxRing)
+    && !IS_RX_RING_INITIALIZED (&AdapterInfo->RxRing))
+  {
+    // Not fatal, every ring then gets a mapping of its own
+    Status = UndiDmaRegionCreate (
+               PCI_IO_FROM_ADAPTER (AdapterInfo),
+               &AdapterInfo->DmaRegion,
+               E1000RingsRegionSize (AdapterInfo, RxCount)
+               );
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("UndiDmaRegionCreate returned %r\n", Status));
+    }
+  }
+
+  if (!IS_TX_RING_INITIALIZED (&AdapterInfo->TxRing)) {
+    Status = TransmitInitialize (AdapterInfo, DEFAULT_TX_DESCRIPTORS);
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("Failed to initialize Tx queue: %r\n", Status));
+      goto Exit;
+    }
+  }
+
+  if (IS_RX_RING_INITIALIZED (&AdapterInfo->RxRing)) {
+    DEBUGPRINT (INIT, ("Reusing Rx ring of %d descriptors\n", AdapterInfo->RxRing.BufferCount));
+    goto Exit;
+  }
+
+  // Optional, the main ring carries control traffic if this fails
+  RxPriorityRingInitialize (AdapterInfo);
+
+  Status = ReceiveInitialize (AdapterInfo, RxCount, RX_BUFFER_SIZE);
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("Failed to initialize Rx queue: %r\n", Status));
+    RxPriorityRingCleanup (AdapterInfo);
+    goto Exit;
+  }
+
+  DEBUGPRINT (
+    INIT, ("Rings allocated, %d Rx descriptors, %d bytes of DMA memory\n",
+    RxCount,
+    E1000RingsFootprint (AdapterInfo))
+  );
+
+Exit:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/** Schedules the release of the stopped Tx and Rx rings after RING_LINGER_TIME.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @return   Release scheduled, or done at once when no timer is available
+**/
+VOID
+E1000RingsLinger (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  EFI_STATUS  Status;
+
+  // Timer and memory services must not be used once ExitBootServices has started
+  if (mExitBootServicesTriggered) {
+    return;
+  }
+
+  if (!IS_TX_RING_INITIALIZED (&AdapterInfo->TxRing)
+    && !IS_RX_RING_INITIALIZED (&AdapterInfo->RxRing))
+  {
+    return;
+  }
+
+  if (AdapterInfo->RingLingerEvent == NULL) {
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    E1000RingsLingerExpired,
+                    AdapterInfo,
+                    &AdapterInfo->RingLingerEvent
+                  );
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("CreateEvent returns %r\n", Status));
+      AdapterInfo->RingLingerEvent = NULL;
+      E1000RingsFree (AdapterInfo);
+      return;
+    }
+  }
+
+  Status = gBS->SetTimer (AdapterInfo->RingLingerEvent, TimerRelative, RING_LINGER_TIME);
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("SetTimer returns %r\n", Status));
+    E1000RingsFree (AdapterInfo);
+  }
+}
+
+/** Frees the Tx and Rx rings immediately and drops the linger timer.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @retval   EFI_SUCCESS   Rings freed or were not allocated
+   @retval   Others        Tx or Rx ring cleanup failed
+**/
+EFI_STATUS
+E1000RingsRelease (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  if (AdapterInfo->RingLingerEvent != NULL) {
+    gBS->CloseEvent (AdapterInfo->RingLingerEvent);
+    AdapterInfo->RingLingerEvent = NULL;
+  }
+
+  return E1000RingsFree (AdapterInfo);
+}
+
+/** Initializes the gigabit adapter, setting up memory addresses, MAC Addresses,
+   Type of card, etc.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @retval   PXE_STATCODE_SUCCESS       Initialization succeeded
+   @retval   PXE_STATCODE_NOT_STARTED   Hardware Init failed
+**/
+PXE_STATCODE
+E1000Inititialize (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  PXE_STATCODE PxeStatcode = PXE_STATCODE_SUCCESS;
+  BOOLEAN      HealthPaused;
+
+  DEBUGPRINT (E1000, ("E1000Inititialize\n"));
+
+
+  DEBUGWAIT (E1000);
+
+  E1000SetSpeedDuplex (AdapterInfo);
+
+  // If the hardware has already been initialized then don't bother with a reset
+  // We want to make sure we do not have to restart autonegotiation and two-pair
+  // downshift.
+  if (!AdapterInfo->HwInitialized) {
+    DEBUGPRINT (E1000, ("Initializing hardware!\n"));
+    HealthPaused = HealthMonitorPause (UNDI_PRIVATE_DATA_FROM_DRIVER_DATA (AdapterInfo));
+
+    // Callers reset the MAC before a changed profile could be split, so
+    // a new split needs a reset of its own
+    if (E1000PacketBufferSplit (AdapterInfo)) {
+      e1000_reset_hw (&AdapterInfo->Hw);
+    }
+    E1000PacketBufferSetup (AdapterInfo);
+    E1000InvalidateMulticastFilters (AdapterInfo);
+    RxVlanFilterInvalidate (AdapterInfo);
+
+    if (e1000_init_hw (&AdapterInfo->Hw) == 0) {
       DEBUGPRINT (E1000, ("e1000_init_hw success\n"));
       PxeStatcode = PXE_STATCODE_SUCCESS;
       AdapterInfo->HwInitialized      = TRUE;
@@ -1155,13 +2070,19 @@ E1000Inititialize (
       DEBUGPRINT (CRITICAL, ("Hardware Init failed\n"));
       PxeStatcode = PXE_STATCODE_NOT_STARTED;
     }
+    HealthMonitorResume (UNDI_PRIVATE_DATA_FROM_DRIVER_DATA (AdapterInfo), HealthPaused);
   } else {
     DEBUGPRINT (E1000, ("Skipping adapter reset\n"));
     PxeStatcode = PXE_STATCODE_SUCCESS;
   }
 
+  // Rings are only allocated once the port is brought up for traffic
   if (PxeStatcode == PXE_STATCODE_SUCCESS) {
-    E1000TxRxConfigure (AdapterInfo);
+    if (EFI_ERROR (E1000RingsAcquire (AdapterInfo))) {
+      PxeStatcode = PXE_STATCODE_NOT_STARTED;
+    } else {
+      E1000TxRxConfigure (AdapterInfo);
+    }
   }
 
   // Re-read the MAC address.  The CLP configured MAC address is being reset by
@@ -1224,6 +2145,360 @@ RxDisable (
   E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RCTL, RctlReg);
 }
 
+/** Marks the multicast filter registers as unknown.
+
+   Must be called whenever the MAC went through a reset, so the next multicast
+   list update rewrites every RAR and MTA register it uses instead of only the
+   changed ones.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+
+   @return   Multicast filter mirror invalidated
+**/
+VOID
+E1000InvalidateMulticastFilters (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  // e1000_init_hw clears RAR[1] and up, so no exact match is left behind
+  AdapterInfo->McastFilter.RarCount = 0;
+  AdapterInfo->McastFilter.HwTableValid = FALSE;
+}
+
+/** Returns the number of receive address registers that may hold exact
+   multicast matches.
+
+   RAR[0] holds the station address. On ICH/PCH parts the remaining entries
+   are shared with the manageability engine and on 82571 the last entry
+   holds a copy of a locally administered address, so those are left alone.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+
+   @return   Number of RAR entries available for multicast, starting at RAR[1]
+**/
+UINT16
+E1000GetMulticastRarCount (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  UINT16 Count;
+
+  if (AdapterInfo->Hw.mac.rar_entry_count < 2) {
+    return 0;
+  }
+  Count = AdapterInfo->Hw.mac.rar_entry_count - 1;
+
+  switch (AdapterInfo->Hw.mac.type) {
+#ifndef NO_82571_SUPPORT
+  case e1000_82571:
+    Count--;
+    break;
+#endif /* !NO_82571_SUPPORT */
+#ifndef NO_ICH8LAN_SUPPORT
+  case e1000_ich8lan:
+  case e1000_ich9lan:
+  case e1000_ich10lan:
+  case e1000_pchlan:
+  case e1000_pch2lan:
+  case e1000_pch_lpt:
+  case e1000_pch_spt:
+  case e1000_pch_cnp:
+#ifdef NAHUM9_HW
+  case e1000_pch_tgp:
+#endif /* NAHUM9_HW */
+#ifdef NAHUM10_HW
+  case e1000_pch_adp:
+#endif /* NAHUM10_HW */
+    return 0;
+#endif /* !NO_ICH8LAN_SUPPORT */
+  default:
+    break;
+  }
+
+  return (Count > MAX_MCAST_ADDRESS_CNT) ? MAX_MCAST_ADDRESS_CNT : Count;
+}
+
+/** Takes a reference on a multicast hash bit, setting the bit in the
+   MTA shadow when it is referenced for the first time.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+   @param[in]   Hash          Multicast hash value
+
+   @return   Reference taken
+**/
+STATIC
+VOID
+MtaHashAcquire (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT16       Hash
+  )
+{
+  MCAST_FILTER *Filter;
+  UINT16        i;
+
+  Filter = &AdapterInfo->McastFilter;
+
+  for (i = 0; i < Filter->RefsUsed; i++) {
+    if (Filter->Refs[i].Hash == Hash) {
+      Filter->Refs[i].RefCount++;
+      return;
+    }
+  }
+
+  // Old references are dropped before new ones are taken, so every live
+  // hash belongs to an entry of the current list
+  ASSERT (Filter->RefsUsed < MAX_MCAST_ADDRESS_CNT);
+  if (Filter->RefsUsed >= MAX_MCAST_ADDRESS_CNT) {
+    return;
+  }
+
+  Filter->Refs[Filter->RefsUsed].Hash = Hash;
+  Filter->Refs[Filter->RefsUsed].RefCount = 1;
+  Filter->RefsUsed++;
+
+  AdapterInfo->Hw.mac.mta_shadow[(Hash >> 5) & (AdapterInfo->Hw.mac.mta_reg_count - 1)] |= (1 << (Hash & 0x1F));
+}
+
+/** Drops a reference on a multicast hash bit, clearing the bit in the
+   MTA shadow once no list entry hashes into it anymore.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+   @param[in]   Hash          Multicast hash value
+
+   @return   Reference dropped
+**/
+STATIC
+VOID
+MtaHashRelease (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT16       Hash
+  )
+{
+  MCAST_FILTER *Filter;
+  UINT16        i;
+
+  Filter = &AdapterInfo->McastFilter;
+
+  for (i = 0; i < Filter->RefsUsed; i++) {
+    if (Filter->Refs[i].Hash != Hash) {
+      continue;
+    }
+
+    if (--Filter->Refs[i].RefCount == 0) {
+      AdapterInfo->Hw.mac.mta_shadow[(Hash >> 5) & (AdapterInfo->Hw.mac.mta_reg_count - 1)] &= ~(1 << (Hash & 0x1F));
+      Filter->RefsUsed--;
+      Filter->Refs[i] = Filter->Refs[Filter->RefsUsed];
+    }
+    return;
+  }
+}
+
+/** Programs the multicast table array with the given multicast list.
+
+   Hash bits are reference counted against the previously programmed list and
+   only the MTA registers whose value actually changed are written, so the
+   receive unit keeps running while the list is updated.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+   @param[in]   McAddrList    Packed array of multicast addresses
+   @param[in]   McAddrCount   Number of addresses in McAddrList
+
+   @return   MTA registers updated
+**/
+VOID
+E1000UpdateMulticastTable (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT8       *McAddrList,
+  IN UINT16       McAddrCount
+  )
+{
+  MCAST_FILTER *Filter;
+  UINT16        NewHash[MAX_MCAST_ADDRESS_CNT];
+  UINT16        i;
+
+  Filter = &AdapterInfo->McastFilter;
+
+  if (McAddrCount > MAX_MCAST_ADDRESS_CNT) {
+    McAddrCount = MAX_MCAST_ADDRESS_CNT;
+  }
+
+  for (i = 0; i < McAddrCount; i++) {
+    NewHash[i] = (UINT16) e1000_hash_mc_addr (&AdapterInfo->Hw, &McAddrList[i * ETH_ALEN]);
+  }
+
+  // Only the shadow changes here, a bit shared by both lists is set again
+  // before the registers are compared against HwTable and never toggles
+  for (i = 0; i < Filter->AppliedCount; i++) {
+    MtaHashRelease (AdapterInfo, Filter->AppliedHash[i]);
+  }
+  for (i = 0; i < McAddrCount; i++) {
+    MtaHashAcquire (AdapterInfo, NewHash[i]);
+  }
+  CopyMem (Filter->AppliedHash, NewHash, McAddrCount * sizeof (UINT16));
+  Filter->AppliedCount = McAddrCount;
+
+  if (AdapterInfo->Hw.mac.ops.update_mc_addr_list != e1000_update_mc_addr_list_generic) {
+
+    // MACs with their own update routine (e.g. PCH2 and later also mirror the
+    // table into the PHY) are left to the shared code, which rebuilds the
+    // same bit vector from the packed list.
+    e1000_update_mc_addr_list (&AdapterInfo->Hw, McAddrList, McAddrCount);
+    CopyMem (Filter->HwTable, AdapterInfo->Hw.mac.mta_shadow, sizeof (Filter->HwTable));
+    Filter->HwTableValid = TRUE;
+    Filter->RegWrites += AdapterInfo->Hw.mac.mta_reg_count;
+    return;
+  }
+
+  for (i = 0; i < AdapterInfo->Hw.mac.mta_reg_count; i++) {
+    if (Filter->HwTableValid
+      && (Filter->HwTable[i] == AdapterInfo->Hw.mac.mta_shadow[i]))
+    {
+      continue;
+    }
+    E1000_WRITE_REG_ARRAY (&AdapterInfo->Hw, E1000_MTA, i, AdapterInfo->Hw.mac.mta_shadow[i]);
+    Filter->HwTable[i] = AdapterInfo->Hw.mac.mta_shadow[i];
+    Filter->RegWrites++;
+  }
+  E1000PciFlush (&AdapterInfo->Hw);
+  Filter->HwTableValid = TRUE;
+}
+
+/** Programs the multicast filters with the given multicast list.
+
+   The first addresses are placed as exact matches into spare receive address
+   registers, only the addresses that do not fit there are hashed into the MTA.
+   Registers are written only when their content changes.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+   @param[in]   McAddrList    Packed array of multicast addresses
+   @param[in]   McAddrCount   Number of addresses in McAddrList
+
+   @return   RAR and MTA registers updated
+**/
+VOID
+E1000UpdateMulticastFilters (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT8       *McAddrList,
+  IN UINT16       McAddrCount
+  )
+{
+  MCAST_FILTER *Filter;
+  UINT8         ZeroAddr[ETH_ALEN];
+  UINT16        RarAvailable;
+  UINT16        OldRarCount;
+  UINT16        i;
+
+  Filter = &AdapterInfo->McastFilter;
+
+  if (McAddrCount > MAX_MCAST_ADDRESS_CNT) {
+    McAddrCount = MAX_MCAST_ADDRESS_CNT;
+  }
+
+  RarAvailable = E1000GetMulticastRarCount (AdapterInfo);
+  OldRarCount = Filter->RarCount;
+
+  for (i = 0; (i < McAddrCount) && (i < RarAvailable); i++) {
+    if ((i < OldRarCount)
+      && (CompareMem (Filter->RarAddr[i], &McAddrList[i * ETH_ALEN], ETH_ALEN) == 0))
+    {
+      continue;
+    }
+    if (e1000_rar_set (&AdapterInfo->Hw, &McAddrList[i * ETH_ALEN], i + 1) != E1000_SUCCESS) {
+      DEBUGPRINT (CRITICAL, ("Failed to set RAR[%d], hashing the remaining addresses\n", i + 1));
+      break;
+    }
+    CopyMem (Filter->RarAddr[i], &McAddrList[i * ETH_ALEN], ETH_ALEN);
+    Filter->RarWrites++;
+  }
+  Filter->RarCount = i;
+
+  // Release the exact match entries no longer in use
+  ZeroMem (ZeroAddr, sizeof (ZeroAddr));
+  for (i = Filter->RarCount; i < OldRarCount; i++) {
+    e1000_rar_set (&AdapterInfo->Hw, ZeroAddr, i + 1);
+    ZeroMem (Filter->RarAddr[i], ETH_ALEN);
+    Filter->RarWrites++;
+  }
+
+  E1000UpdateMulticastTable (
+    AdapterInfo,
+    &McAddrList[Filter->RarCount * ETH_ALEN],
+    McAddrCount - Filter->RarCount
+  );
+
+  DEBUGPRINT (
+    E1000, ("E1000: %d exact, %d hashed multicast, RAR writes %d, MTA writes %d, Rx disabled windows %d\n",
+    Filter->RarCount,
+    Filter->AppliedCount,
+    Filter->RarWrites,
+    Filter->RegWrites,
+    Filter->RxDisabledWindows)
+  );
+}
+
+/** Checks whether a multicast address is on the multicast list programmed
+   into the device.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+   @param[in]   Addr          Destination MAC address of the received frame
+
+   @retval   TRUE    Address is on the list
+   @retval   FALSE   Address only matched through hashing or all-multicast
+**/
+BOOLEAN
+E1000IsMulticastListed (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT8       *Addr
+  )
+{
+  MCAST_FILTER *Filter;
+  UINTN         Slot;
+  UINT8         Index;
+
+  Filter = &AdapterInfo->McastFilter;
+
+  for (Slot = MCAST_LOOKUP_SLOT (Addr);
+       (Index = Filter->Lookup[Slot]) != 0;
+       Slot = (Slot + 1) & (MCAST_LOOKUP_SIZE - 1))
+  {
+    if ((Index <= AdapterInfo->McastList.Length)
+      && (CompareMem (AdapterInfo->McastList.McAddr[Index - 1], Addr, PXE_HWADDR_LEN_ETHER) == 0))
+    {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/** Rebuilds the table E1000IsMulticastListed looks addresses up in.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+
+   @return   McastFilter.Lookup filled from McastList
+**/
+STATIC
+VOID
+E1000BuildMulticastLookup (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  MCAST_FILTER *Filter;
+  UINTN         Slot;
+  UINT16        i;
+
+  Filter = &AdapterInfo->McastFilter;
+  ZeroMem (Filter->Lookup, sizeof (Filter->Lookup));
+
+  // The table is at least twice the list size, a free slot is always found
+  for (i = 0; i < AdapterInfo->McastList.Length; i++) {
+    Slot = MCAST_LOOKUP_SLOT (AdapterInfo->McastList.McAddr[i]);
+    while (Filter->Lookup[Slot] != 0) {
+      Slot = (Slot + 1) & (MCAST_LOOKUP_SIZE - 1);
+    }
+    Filter->Lookup[Slot] = (UINT8) (i + 1);
+  }
+}
+
 /** Changes filter settings
 
    @param[in]   AdapterInfo  Pointer to the NIC data structure information which the
@@ -1244,10 +2519,12 @@ E1000SetFilter (
   )
 {
   PXE_CPB_RECEIVE_FILTERS *CpbReceiveFilter;
+  UINT8                    McAddrList[MAX_MCAST_ADDRESS_CNT][ETH_ALEN];
   UINT32                   UpdateRCTL;
   UINT16                   CfgFilter;
   UINT16                   OldFilter;
   UINT16                   MulticastCount;
+  BOOLEAN                  ForcedAllMulti;
   UINT16                   i;
   UINT16                   j;
 
@@ -1255,6 +2532,7 @@ E1000SetFilter (
 
   CpbReceiveFilter = (PXE_CPB_RECEIVE_FILTERS *) (UINTN) Cpb;
   OldFilter = AdapterInfo->RxFilter;
+  ForcedAllMulti = AdapterInfo->McastFilter.ForcedAllMulti;
 
   // only these bits need a change in the configuration
   // actually change in bcast requires configure but we ignore that change
@@ -1265,6 +2543,7 @@ E1000SetFilter (
   if ((OldFilter & CfgFilter) != (NewFilter & CfgFilter)) {
 
     UpdateRCTL = E1000_READ_REG (&AdapterInfo->Hw, E1000_RCTL);
+    UpdateRCTL &= ~(E1000_RCTL_UPE | E1000_RCTL_MPE);
 
     if (NewFilter & PXE_OPFLAGS_RECEIVE_FILTER_PROMISCUOUS) {
 
@@ -1273,7 +2552,9 @@ E1000SetFilter (
     }
 
 
-    if (NewFilter & PXE_OPFLAGS_RECEIVE_FILTER_ALL_MULTICAST) {
+    if ((NewFilter & PXE_OPFLAGS_RECEIVE_FILTER_ALL_MULTICAST)
+      || AdapterInfo->McastFilter.ForcedAllMulti)
+    {
 
       // add the MPE bit to the variable to be written to the RCTL
       UpdateRCTL |= E1000_RCTL_MPE;
@@ -1284,6 +2565,7 @@ E1000SetFilter (
     // while changing filters.
     if (AdapterInfo->RxRing.IsRunning) {
       RxDisable (AdapterInfo);
+      AdapterInfo->McastFilter.RxDisabledWindows++;
     }
 
     UpdateRCTL |= E1000_RCTL_BAM;
@@ -1303,45 +2585,60 @@ E1000SetFilter (
 
     // copy the list
     if (CpbReceiveFilter != NULL) {
-      UINT8 McAddrList[MAX_MCAST_ADDRESS_CNT][ETH_ALEN];
-
-      MulticastCount = AdapterInfo->McastList.Length = (UINT16) (CpbSize / PXE_MAC_LENGTH);
+      MulticastCount = (UINT16) (CpbSize / PXE_MAC_LENGTH);
       DEBUGPRINT (E1000, ("E1000: MulticastCount=%d\n", MulticastCount));
 
+      // A list that doesn't fit can only be served by receiving all multicast
+      ForcedAllMulti = (BOOLEAN) (MulticastCount > MAX_MCAST_ADDRESS_CNT);
+      if (ForcedAllMulti) {
+        MulticastCount = MAX_MCAST_ADDRESS_CNT;
+      }
+      AdapterInfo->McastList.Length = MulticastCount;
+
       ZeroMem (AdapterInfo->McastList.McAddr, MAX_MCAST_ADDRESS_CNT * PXE_MAC_LENGTH);
       CopyMem (
         AdapterInfo->McastList.McAddr,
         (VOID *) (UINTN) CpbReceiveFilter->MCastList,
-        CpbSize
+        MulticastCount * PXE_MAC_LENGTH
       );
+    }
 
-      // Copy the multicast address list into a form that can be accepted by the
-      // shared code.
-      for (i = 0; (i < MulticastCount && i < MAX_MCAST_ADDRESS_CNT); i++) {
-        DEBUGPRINT (E1000, ("E1000: MulticastAddress %d:", i));
-        for (j = 0; j < ETH_ALEN; j++) {
-          McAddrList[i][j] = AdapterInfo->McastList.McAddr[i][j];
-          DEBUGPRINT (E1000, ("%02x", CpbReceiveFilter->MCastList[i][j]));
-        }
-        DEBUGPRINT (E1000, ("\n"));
-      }
-
-      TransmitLockIo (AdapterInfo, TRUE);
+    E1000BuildMulticastLookup (AdapterInfo);
 
-      //Rx unit needs to be disabled while changing filters.
-      if (AdapterInfo->RxRing.IsRunning) {
-        RxDisable (AdapterInfo);
+    // Copy the multicast address list into a form that can be accepted by the
+    // shared code. A disabled multicast filter programs an empty table.
+    MulticastCount = 0;
+    if ((NewFilter & PXE_OPFLAGS_RECEIVE_FILTER_FILTERED_MULTICAST) != 0) {
+      MulticastCount = AdapterInfo->McastList.Length;
+    } else {
+      ForcedAllMulti = FALSE;
+    }
+    for (i = 0; (i < MulticastCount && i < MAX_MCAST_ADDRESS_CNT); i++) {
+      DEBUGPRINT (E1000, ("E1000: MulticastAddress %d:", i));
+      for (j = 0; j < ETH_ALEN; j++) {
+        McAddrList[i][j] = AdapterInfo->McastList.McAddr[i][j];
+        DEBUGPRINT (E1000, ("%02x", McAddrList[i][j]));
       }
-      e1000_update_mc_addr_list (
-        &AdapterInfo->Hw,
-        &McAddrList[0][0],
-        MulticastCount
-      );
-      if (AdapterInfo->RxRing.IsRunning) {
-        RxEnable (AdapterInfo);
+      DEBUGPRINT (E1000, ("\n"));
+    }
+
+    // Only the changed RAR and MTA registers are written so the Rx unit can
+    // stay enabled while the list is updated.
+    TransmitLockIo (AdapterInfo, TRUE);
+    E1000UpdateMulticastFilters (AdapterInfo, &McAddrList[0][0], MulticastCount);
+
+    if (ForcedAllMulti != AdapterInfo->McastFilter.ForcedAllMulti) {
+      AdapterInfo->McastFilter.ForcedAllMulti = ForcedAllMulti;
+      if ((AdapterInfo->RxFilter & PXE_OPFLAGS_RECEIVE_FILTER_ALL_MULTICAST) == 0) {
+        DEBUGPRINT (E1000, ("E1000: Multicast list overflow, all multicast %d\n", ForcedAllMulti));
+        if (ForcedAllMulti) {
+          E1000SetRegBits (AdapterInfo, E1000_RCTL, E1000_RCTL_MPE);
+        } else {
+          E1000ClearRegBits (AdapterInfo, E1000_RCTL, E1000_RCTL_MPE);
+        }
       }
-      TransmitLockIo (AdapterInfo, FALSE);
     }
+    TransmitLockIo (AdapterInfo, FALSE);
 
     // are we setting the list or resetting??
     if ((NewFilter & PXE_OPFLAGS_RECEIVE_FILTER_FILTERED_MULTICAST) != 0) {
@@ -1353,6 +2650,15 @@ E1000SetFilter (
     }
   }
 
+  // The network stack reconfigures the filters whenever a VLAN is added, pick
+  // up the new VLAN table here. The VLAN set is only read again after a
+  // notification and before taking the lock, only the VFTA words that
+  // changed are written under it.
+  RxVlanFilterRefresh (AdapterInfo);
+  TransmitLockIo (AdapterInfo, TRUE);
+  RxVlanFilterUpdate (AdapterInfo);
+  TransmitLockIo (AdapterInfo, FALSE);
+
   if (NewFilter != 0) {
 
     // Enable unicast and start the RU
@@ -1847,6 +3153,94 @@ GetChipTypeStr (
   return EFI_SUCCESS;
 }
 
+/** Copies space padded ASCII field of SFP ID page into a NULL terminated string.
+
+   @param[in]   Field      Points to the field in the SFP cache
+   @param[out]  String     Output buffer of E1000_SFF_VENDOR_STR_LEN + 1 characters
+**/
+STATIC
+VOID
+CopySfpVendorField (
+  IN  UINT8  *Field,
+  OUT CHAR8  *String
+  )
+{
+  UINTN  Length;
+
+  Length = E1000_SFF_VENDOR_STR_LEN;
+  CopyMem (String, Field, Length);
+  while ((Length > 0) && ((String[Length - 1] == ' ') || (String[Length - 1] == '\0'))) {
+    Length--;
+  }
+  String[Length] = '\0';
+}
+
+/** Gets SFP module vendor and part number string from the SFP cache.
+
+   @param[in]   UndiPrivateData   Points to the driver instance private data
+   @param[out]  SfpModuleStr      Points to the output string buffer
+
+   @retval   EFI_SUCCESS   SFP module string successfully retrieved
+**/
+EFI_STATUS
+GetSfpModuleStr (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT EFI_STRING         SfpModuleStr
+  )
+{
+  struct e1000_hw               *Hw;
+  struct e1000_dev_spec_82575   *DevSpec;
+  CHAR8                         VendorName[E1000_SFF_VENDOR_STR_LEN + 1];
+  CHAR8                         PartNumber[E1000_SFF_VENDOR_STR_LEN + 1];
+  UINT32                        LinkMode;
+
+  Hw = &UndiPrivateData->NicInfo.Hw;
+  UnicodeSPrint (SfpModuleStr, HII_MAX_STR_LEN_BYTES, L"N/A");
+
+  if ((Hw->mac.type < e1000_82575)
+    || (Hw->mac.type == e1000_i210)
+    || (Hw->mac.type == e1000_i211))
+  {
+    return EFI_SUCCESS;
+  }
+
+  // Only SerDes and SGMII ports have an SFP cage
+  LinkMode = E1000_READ_REG (Hw, E1000_CTRL_EXT) & E1000_CTRL_EXT_LINK_MODE_MASK;
+  if ((LinkMode != E1000_CTRL_EXT_LINK_MODE_PCIE_SERDES)
+    && (LinkMode != E1000_CTRL_EXT_LINK_MODE_SGMII))
+  {
+    return EFI_SUCCESS;
+  }
+
+  // One identifier byte read tells if the module was swapped, the rest comes
+  // from the cache. A cache dropped by a reset is filled again here.
+  DevSpec = &Hw->dev_spec._82575;
+  e1000_check_sfp_module_82575 (Hw);
+  if (e1000_read_sfp_cache_82575 (Hw) != E1000_SUCCESS) {
+    return EFI_SUCCESS;
+  }
+
+  if ((DevSpec->sfp_cache[E1000_SFF_IDENTIFIER_OFFSET] != E1000_SFF_IDENTIFIER_SFP)
+    && (DevSpec->sfp_cache[E1000_SFF_IDENTIFIER_OFFSET] != E1000_SFF_IDENTIFIER_SFF))
+  {
+    return EFI_SUCCESS;
+  }
+
+  CopySfpVendorField (&DevSpec->sfp_cache[E1000_SFF_VENDOR_NAME_OFFSET], VendorName);
+  CopySfpVendorField (&DevSpec->sfp_cache[E1000_SFF_VENDOR_PN_OFFSET], PartNumber);
+
+  UnicodeSPrint (
+    SfpModuleStr,
+    HII_MAX_STR_LEN_BYTES,
+    L"%a %a (%d MBd)",
+    VendorName,
+    PartNumber,
+    DevSpec->sfp_cache[E1000_SFF_BITRATE_OFFSET] * 100
+    );
+
+  return EFI_SUCCESS;
+}
+
 /** Gets HII formset help string ID.
 
    @param[in]   UndiPrivateData  Pointer to driver private data structure
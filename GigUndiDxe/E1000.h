@@ -44,6 +44,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Protocol/PlatformToDriverConfiguration.h>
 #include <Protocol/FirmwareManagement.h>
 #include <Protocol/DriverHealth.h>
+#include <Protocol/VlanConfig.h>
+#include <Protocol/ManagedNetwork.h>
 
 #include <Protocol/HiiConfigRouting.h>
 #include <Protocol/FormBrowser2.h>
@@ -59,10 +61,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/UefiLib.h>
 #include <Library/BaseLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
+#include <Library/TimerLib.h>
 
 #include <IndustryStandard/Pci.h>
 
@@ -91,6 +95,7 @@ typedef struct DRIVER_DATA_S DRIVER_DATA;
 
 #include "LanEngine/Receive.h"
 #include "LanEngine/Transmit.h"
+#include "RxFilter.h"
 
 
 #define MAX_NIC_INTERFACES  256
@@ -138,6 +143,16 @@ typedef struct DRIVER_DATA_S DRIVER_DATA;
 #define E1000_PBA_40K 0x0028
 #define E1000_PBA_48K 0x0030    /* 48KB, default RX allocation */
 
+// Per-port variables, name prefix followed by the permanent MAC address
+#define PORT_VARIABLE_NAME_LENGTH            40
+
+// Receive optimized packet buffer profile
+#define PACKET_BUFFER_PROFILE_VARIABLE_NAME  L"PacketBufferProfile"
+#define PACKET_BUFFER_TX_KB                  8     /* Tx allocation left, a few untagged frames */
+#define PACKET_BUFFER_MAX_FRAME              1522  /* VLAN tagged frame with CRC */
+#define PACKET_BUFFER_WATER_MASK             0x0000FFF0 /* FCRTH/FCRTL granularity of all MACs */
+#define E1000_TXPBS_SIZE_I210_MASK           0x0000003F /* Tx packet buffer 0 size */
+
 // EEPROM Word Defines:
 #define INIT_CONTROL_WORD_2                 0x0F
 #define INIT_CONTROL_WORD_2_PWR_DOWN_BIT    BIT (6)
@@ -538,6 +553,13 @@ typedef struct e1000_rx_desc E1000_RECEIVE_DESCRIPTOR;
 
 #define DEFAULT_RX_DESCRIPTORS 64
 #define DEFAULT_TX_DESCRIPTORS 8
+#define MIN_RX_DESCRIPTORS     16
+
+// Descriptor ring lengths must be a multiple of 128 bytes
+#define RING_DESCRIPTOR_ALIGN  8
+
+// Rings stay allocated this long after Shutdown so a quick re-initialize is cheap
+#define RING_LINGER_TIME       EFI_TIMER_PERIOD_SECONDS (2)
 
 #pragma pack(1)
 typedef struct {
@@ -576,11 +598,88 @@ typedef struct {
   UINT8  McAddr[MAX_MCAST_ADDRESS_CNT][PXE_MAC_LENGTH]; // 8*32 is the size
 } MCAST_LIST;
 
+/* Reference count of one multicast hash bit. Several list entries may hash
+   into the same MTA bit, which may only be cleared once all of them are gone. */
+typedef struct {
+  UINT16 Hash;
+  UINT16 RefCount;
+} MTA_HASH_REF;
+
+/* Open addressed table of McastList indexes used on receive, a power of two
+   at least twice the list size so probing stays short */
+#define MCAST_LOOKUP_SIZE  32
+#define MCAST_LOOKUP_SLOT(Addr) \
+  (((Addr)[3] ^ (Addr)[4] ^ (Addr)[5]) & (MCAST_LOOKUP_SIZE - 1))
+
+/* Driver side view of the multicast filters. The first list entries are
+   exact matches in spare receive address registers, the overflow is hashed
+   into the MTA. The desired MTA bit vector is kept by the shared code in
+   Hw.mac.mta_shadow, HwTable mirrors what was last written to the MTA
+   registers so that only changed registers are rewritten. */
+typedef struct {
+  UINT8        RarAddr[MAX_MCAST_ADDRESS_CNT][ETH_ALEN]; // exact matches, RAR[1] onwards
+  UINT16       RarCount;
+  MTA_HASH_REF Refs[MAX_MCAST_ADDRESS_CNT];
+  UINT16       RefsUsed;
+  UINT16       AppliedHash[MAX_MCAST_ADDRESS_CNT]; // hashes of the overflow currently programmed
+  UINT16       AppliedCount;
+  UINT32       HwTable[MAX_MTA_REG];
+  BOOLEAN      HwTableValid; // FALSE after reset, forces a full rewrite
+  BOOLEAN      ForcedAllMulti; // list did not fit, receiving all multicast
+  UINT8        Lookup[MCAST_LOOKUP_SIZE]; // McastList index + 1, 0 for a free slot
+
+  UINT32       RarWrites;          // RAR register pairs written
+  UINT32       RegWrites;          // MTA register writes issued
+  UINT32       RxDisabledWindows;  // number of times Rx was stopped for a filter change
+  UINT32       SwRejectedFrames;   // multicast frames passed up that are not on the list
+} MCAST_FILTER;
+
+STATIC_ASSERT (
+  MCAST_LOOKUP_SIZE >= 2 * MAX_MCAST_ADDRESS_CNT,
+  "Multicast lookup table too small for the multicast list"
+  );
+
+/* Adapter data only touched at init, by statistics and by diagnostics. Kept
+   out of DRIVER_DATA so it does not spread the per packet fields apart. */
+typedef struct {
+  UINT32                  PciConfig[MAX_PCI_CONFIG_LEN];
+  UINT32                  NvData[MAX_EEPROM_LEN];
+  struct e1000_hw_stats   Stats;
+} DRIVER_DATA_COLD;
+
+/* Cache lines holding the DRIVER_DATA fields touched by every Transmit,
+   Receive and Get Status call, checked against the layout below */
+#define DRIVER_DATA_HOT_SIZE  (4 * UNDI_DMA_CACHE_LINE)
+
 typedef struct DRIVER_DATA_S {
+
+  // Per packet state first, DRIVER_DATA starts on a cache line
+  EFI_PCI_IO_PROTOCOL     *PciIo;
+  UINTN                   DriverBusy;
+  UINTN                   VersionFlag; // Indicates UNDI version 3.0 or 3.1
+
+  // UNDI callbacks
+  BS_PTR                  Delay;
+  VIRT_PHYS               Virt2Phys;
+  BLOCK                   Block;
+  MEM_IO                  MemIo;
+  MAP_MEM                 MapMem;
+  UNMAP_MEM               UnMapMem;
+  SYNC_MEM                SyncMem;
+
   UINT16                  State; // stopped, started or initialized
+  UINT16                  RxFilter;
+  UINT8                   IntMask;
+  BOOLEAN                 SurpriseRemoval;
+
+  TRANSMIT_RING           TxRing;
+  RECEIVE_RING            RxRing;
 
+  // Register access goes through Hw.back and Hw.hw_addr right after the above
   struct e1000_hw         Hw;
-  struct e1000_hw_stats   Stats;
+
+  DRIVER_DATA_COLD        *Cold;
+
   UINTN                   Segment;
   UINTN                   Bus;
   UINTN                   Device;
@@ -596,11 +695,7 @@ typedef struct DRIVER_DATA_S {
 
   UINT8                   BroadcastNodeAddress[PXE_MAC_LENGTH];
 
-  UINT32                  PciConfig[MAX_PCI_CONFIG_LEN];
-  UINT32                  NvData[MAX_EEPROM_LEN];
-
   UINTN                   HwInitialized;
-  UINTN                   DriverBusy;
   UINT16                  LinkSpeed; // requested (forced) link speed
   UINT8                   DuplexMode; // requested duplex
   UINT8                   CableDetect; // 1 to detect and 0 not to detect the cable
@@ -611,42 +706,53 @@ typedef struct DRIVER_DATA_S {
                                      // (e.g. in case iSCSI driver loaded on port)
 
   UINT64                  UniqueId;
-  EFI_PCI_IO_PROTOCOL     *PciIo;
   UINT64                  OriginalPciAttributes;
 
-  // UNDI callbacks
-  BS_PTR                  Delay;
-  VIRT_PHYS               Virt2Phys;
-  BLOCK                   Block;
-  MEM_IO                  MemIo;
-  MAP_MEM                 MapMem;
-  UNMAP_MEM               UnMapMem;
-  SYNC_MEM                SyncMem;
-
   UINT8                   IoBarIndex;
-  UINT16                  RxFilter;
-  UINT8                   IntMask;
 
   MCAST_LIST              McastList;
+  MCAST_FILTER            McastFilter;
+  RX_DROP_POLICY          RxDropPolicy;
+  RX_VLAN_FILTER          VlanFilter;
+  RX_PRIORITY_RING        PriorityRxRing;
 
-  RECEIVE_RING            RxRing;
-  TRANSMIT_RING           TxRing;
+  UNDI_DMA_REGION         DmaRegion;       // all rings are carved from this single mapping
+  UINT16                  RxRingRequest;   // Rx descriptors asked for by UNDI Initialize, 0 for default
+  EFI_EVENT               RingLingerEvent; // frees the rings once they sat idle for RING_LINGER_TIME
+
+  UINT8                   PacketBufferProfile; // PACKET_BUFFER_PROFILE_* of the port
 
   BOOLEAN                 MacAddrOverride;
   BOOLEAN                 FlashWriteInProgress;
-  BOOLEAN                 SurpriseRemoval;
-  UINTN                   VersionFlag; // Indicates UNDI version 3.0 or 3.1
 } DRIVER_DATA;
 
+STATIC_ASSERT (
+  OFFSET_OF (DRIVER_DATA, Hw) <= DRIVER_DATA_HOT_SIZE,
+  "Per packet fields of DRIVER_DATA no longer fit their cache lines"
+  );
+
 typedef struct HII_INFO_S {
   EFI_HANDLE           HiiInstallHandle;
   EFI_HII_HANDLE       HiiPkgListHandle;
   HII_CFG_ACCESS_INFO  HiiCfgAccessInfo;
 
   BOOLEAN              AltMacAddrSupported;
+
+  CHAR8                *InvLanguages;      ///< Package list languages, NULL until first HII access
+  BOOLEAN              InvAgnosticDone;    ///< Language agnostic inventory strings set
+  UINT64               InvLangDone;        ///< Bit per InvLanguages entry with inventory strings set
+  UINT64               InvLangAll;         ///< Bits of all InvLanguages entries
+
+  BOOLEAN              TxnAutoneg;            ///< Hw.mac.autoneg when the NVM transaction was opened
+  UINT8                TxnForcedSpeedDuplex;  ///< Hw.mac.forced_speed_duplex at the same time
+
+  UINT32               ConfigEpoch;        ///< Advanced when NVM or link state changes
+  UINT32               EpochNvmGeneration; ///< Hw.nvm.generation seen in ConfigEpoch
+  BOOLEAN              EpochLinkUp;        ///< Link state seen in ConfigEpoch
 } HII_INFO;
 
 typedef struct UNDI_PRIVATE_DATA_S {
+  DRIVER_DATA                               NicInfo; // first, private data is page allocated
   UINTN                                     Signature;
   UINTN                                     IfId;
   EFI_NETWORK_INTERFACE_IDENTIFIER_PROTOCOL NiiProtocol31;
@@ -656,8 +762,8 @@ typedef struct UNDI_PRIVATE_DATA_S {
   EFI_HANDLE                                FmpInstallHandle;
   EFI_DEVICE_PATH_PROTOCOL                  *Undi32BaseDevPath;
   EFI_DEVICE_PATH_PROTOCOL                  *Undi32DevPath;
-  DRIVER_DATA                               NicInfo;
   CHAR16                                    *Brand;
+  BOOLEAN                                   IsWolSupported;
   EFI_UNICODE_STRING_TABLE                  *ControllerNameTable;
   BOOLEAN                                   IsChildInitialized;
   HII_INFO                                  HiiInfo;
@@ -665,6 +771,8 @@ typedef struct UNDI_PRIVATE_DATA_S {
 
 
   EFI_ADAPTER_INFORMATION_PROTOCOL          AdapterInformation;
+  ADAPTER_INFO_LOOPBACK_PERF                LoopbackPerf;
+  HEALTH_MONITOR                            Health;
   UINT32                                    LastAttemptVersion;
   UINT32                                    LastAttemptStatus;
 } UNDI_PRIVATE_DATA;
@@ -744,6 +852,45 @@ E1000Inititialize (
   IN DRIVER_DATA *AdapterInfo
   );
 
+/** Makes sure the Tx and Rx rings are allocated before the port carries traffic.
+
+   Rings still lingering from the previous Shutdown are reused when their size
+   matches the current request, otherwise they are replaced.
+   Rings that are running are never reallocated.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @retval   EFI_SUCCESS   Rings are allocated and handed to the hardware
+   @retval   Others        Allocation of one of the rings failed
+**/
+EFI_STATUS
+E1000RingsAcquire (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Schedules the release of the stopped Tx and Rx rings after RING_LINGER_TIME.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @return   Release scheduled, or done at once when no timer is available
+**/
+VOID
+E1000RingsLinger (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Frees the Tx and Rx rings immediately and drops the linger timer.
+
+   @param[in]   AdapterInfo   Pointer to adapter structure
+
+   @retval   EFI_SUCCESS   Rings freed or were not allocated
+   @retval   Others        Tx or Rx ring cleanup failed
+**/
+EFI_STATUS
+E1000RingsRelease (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
 #define PCI_CLASS_MASK          0xFF00
 #define PCI_SUBCLASS_MASK       0x00FF
 
@@ -768,6 +915,10 @@ E1000FirstTimeInit (
 
 #define MAX_QUEUE_ENABLE_TIME   200
 
+// Bound of the single wait for all ports to stop DMA at ExitBootServices
+#define QUIESCE_TIMEOUT_US      10000
+#define QUIESCE_POLL_US         10
+
 /** Starts the receive unit.
 
    @param[in]   AdapterInfo   Pointer to the NIC data structure information
@@ -1005,6 +1156,19 @@ GetChipTypeStr (
   OUT EFI_STRING         ChipTypeStr
   );
 
+/** Gets SFP module vendor and part number string from the SFP cache.
+
+   @param[in]   UndiPrivateData   Points to the driver instance private data
+   @param[out]  SfpModuleStr      Points to the output string buffer
+
+   @retval   EFI_SUCCESS   SFP module string successfully retrieved
+**/
+EFI_STATUS
+GetSfpModuleStr (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT EFI_STRING         SfpModuleStr
+  );
+
 /** Gets HII formset help string ID.
 
    @param[in]   UndiPrivateData  Pointer to driver private data structure
@@ -1052,6 +1216,155 @@ E1000Shutdown (
   IN DRIVER_DATA *AdapterInfo
   );
 
+/** First phase of a quiesce, requests the adapter to stop all DMA without waiting.
+
+   Disables the Tx and Rx queues, gives the management pass through back to
+   the firmware and blocks new bus master requests. Meant for the
+   ExitBootServices path, where memory services are no longer available.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @return   DMA stop requested
+**/
+VOID
+E1000QuiesceStart (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Second phase of a quiesce, checks whether the adapter stopped all DMA.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @retval   TRUE    Queues are disabled and no bus master request is pending
+   @retval   FALSE   Adapter is still busy
+**/
+BOOLEAN
+E1000QuiesceDone (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Reads a one byte per-port setting.
+
+   @param[in]    AdapterInfo   Pointer to the driver structure
+   @param[in]    Prefix        Name of the setting
+   @param[out]   Value         Stored value
+
+   @retval   EFI_SUCCESS    Value read
+   @retval   !EFI_SUCCESS   Nothing stored or failed to read the variable
+**/
+EFI_STATUS
+E1000PortVariableGet (
+  IN  DRIVER_DATA *AdapterInfo,
+  IN  CHAR16      *Prefix,
+  OUT UINT8       *Value
+  );
+
+/** Stores a one byte per-port setting in a non-volatile variable.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+   @param[in]   Prefix        Name of the setting
+   @param[in]   Value         Value to store
+
+   @retval   EFI_SUCCESS    Value stored
+   @retval   !EFI_SUCCESS   Failed to write the variable
+**/
+EFI_STATUS
+E1000PortVariableSet (
+  IN DRIVER_DATA *AdapterInfo,
+  IN CHAR16      *Prefix,
+  IN UINT8        Value
+  );
+
+/** Reads the persisted packet buffer profile of the port.
+
+   Falls back to PACKET_BUFFER_PROFILE_STANDARD when nothing was stored yet.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @return   AdapterInfo->PacketBufferProfile initialized
+**/
+VOID
+E1000PacketBufferProfileLoad (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Persists the packet buffer profile of the port.
+
+   The profile is programmed by the next full reset of the port.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+   @param[in]   Profile       PACKET_BUFFER_PROFILE_* value
+
+   @retval   EFI_SUCCESS             Profile stored
+   @retval   EFI_INVALID_PARAMETER   Unknown profile
+   @retval   EFI_UNSUPPORTED         Receive optimized profile not supported by the MAC
+   @retval   !EFI_SUCCESS            Failed to store the profile
+**/
+EFI_STATUS
+E1000PacketBufferProfileSet (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT8        Profile
+  );
+
+/** Tells whether the receive optimized packet buffer profile has an effect
+   on the port, that is whether E1000PacketBufferSplit can move space from
+   transmit to receive on its MAC.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @retval   TRUE    Receive optimized profile supported
+   @retval   FALSE   Only the standard profile applies
+**/
+BOOLEAN
+E1000PacketBufferProfileSupported (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Sets up the flow control thresholds according to the packet buffer
+   profile of the port and the packet buffer split in effect.
+
+   Must be called after the MAC reset that applied the split and before
+   e1000_init_hw, which writes the thresholds.
+
+   @param[in]   AdapterInfo   Pointer to the driver structure
+
+   @return   Hw.fc set up
+**/
+VOID
+E1000PacketBufferSetup (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Marks the multicast filter registers as unknown.
+
+   Must be called whenever the MAC went through a reset, so the next multicast
+   list update rewrites every RAR and MTA register it uses instead of only the
+   changed ones.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+
+   @return   Multicast filter mirror invalidated
+**/
+VOID
+E1000InvalidateMulticastFilters (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Checks whether a multicast address is on the multicast list programmed
+   into the device.
+
+   @param[in]   AdapterInfo   Pointer to the adapter structure
+   @param[in]   Addr          Destination MAC address of the received frame
+
+   @retval   TRUE    Address is on the list
+   @retval   FALSE   Address only matched through hashing or all-multicast
+**/
+BOOLEAN
+E1000IsMulticastListed (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT8       *Addr
+  );
+
 /** Changes filter settings
 
    @param[in]   AdapterInfo   Pointer to the NIC data structure information which the UNDI driver is layering on..
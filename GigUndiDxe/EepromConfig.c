@@ -257,6 +257,40 @@ GetLinkSpeed (
   return EFI_SUCCESS;
 }
 
+/** Resets the adapter so that a changed speed/duplex setting takes effect.
+   If the adapter was initialized on entry it is initialized again and the
+   receive unit is re-enabled if it was running.
+
+   @param[in]   UndiPrivateData  Pointer to driver private data structure
+**/
+STATIC
+VOID
+RestartLink (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData
+  )
+{
+  BOOLEAN ReceiveStarted;
+
+  if (!UndiPrivateData->NicInfo.UndiEnabled) {
+    return;
+  }
+
+  ReceiveStarted = UndiPrivateData->NicInfo.RxRing.IsRunning;
+
+  e1000_reset_hw (&UndiPrivateData->NicInfo.Hw);
+  UndiPrivateData->NicInfo.HwInitialized = FALSE;
+  if (UndiPrivateData->NicInfo.State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    E1000Inititialize (&UndiPrivateData->NicInfo);
+    DEBUGPRINT (HII, ("E1000Inititialize complete\n"));
+
+    //  Restart the receive unit if it was running on entry
+    if (ReceiveStarted) {
+      DEBUGPRINT (HII, ("RESTARTING RU\n"));
+      E1000ReceiveStart (&UndiPrivateData->NicInfo);
+    }
+  }
+}
+
 /** Sets link speed setting for adapter.
 
    @param[in]   UndiPrivateData  Pointer to driver private data structure
@@ -276,7 +310,6 @@ SetLinkSpeed (
   UINT16 SetupWord;
   UINT16 OldSetupWord;
   UINT16 CustomConfigWord;
-  UINT8  ReceiveStarted;
 
   struct e1000_hw *hw = &UndiPrivateData->NicInfo.Hw;
 
@@ -370,24 +403,7 @@ SetLinkSpeed (
     }
 
     // After speed/duplex setting completes we need to perform a full reset of the adapter.
-    // If the adapter was initialized on entry then force a full reset of the adapter.
-    // Also re-enable the receive unit if it was enabled before we started the PHY loopback test.
-    if (UndiPrivateData->NicInfo.UndiEnabled) {
-      ReceiveStarted = UndiPrivateData->NicInfo.RxRing.IsRunning;
-
-      e1000_reset_hw (&UndiPrivateData->NicInfo.Hw);
-      UndiPrivateData->NicInfo.HwInitialized = FALSE;
-      if (UndiPrivateData->NicInfo.State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
-        E1000Inititialize (&UndiPrivateData->NicInfo);
-        DEBUGPRINT (HII, ("E1000Inititialize complete\n"));
-
-        //  Restart the receive unit if it was running on entry
-        if (ReceiveStarted) {
-          DEBUGPRINT (HII, ("RESTARTING RU\n"));
-          E1000ReceiveStart (&UndiPrivateData->NicInfo);
-        }
-      }
-    }
+    RestartLink (UndiPrivateData);
     DEBUGPRINT (HII, ("ADAPTER RESET COMPLETE\n"));
   }
   return EFI_SUCCESS;
@@ -971,3 +987,78 @@ UpdateNvmChecksum (
   return EFI_SUCCESS;
 }
 
+/** Opens NVM write transaction. Until it is committed NVM writes are staged
+   and checksum updates deferred, so a batch of changes costs one commit.
+
+   @param[in]   UndiPrivateData   Pointer to driver private data structure
+**/
+VOID
+BeginNvmTransaction (
+  IN  UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  struct e1000_hw *Hw;
+
+  Hw = &UndiPrivateData->NicInfo.Hw;
+
+  // Setters apply the staged link setting right away, keep the one to go back to
+  if (Hw->nvm.txn.depth == 0) {
+    UndiPrivateData->HiiInfo.TxnAutoneg           = Hw->mac.autoneg;
+    UndiPrivateData->HiiInfo.TxnForcedSpeedDuplex = Hw->mac.forced_speed_duplex;
+  }
+
+  e1000_nvm_txn_begin (Hw);
+}
+
+/** Commits NVM write transaction - writes staged words and updates checksum once
+
+   @param[in]   UndiPrivateData   Pointer to driver private data structure
+
+   @retval      EFI_SUCCESS       Transaction committed
+   @retval      EFI_DEVICE_ERROR  Failed to write NVM or update its checksum
+**/
+EFI_STATUS
+CommitNvmTransaction (
+  IN  UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  if (e1000_nvm_txn_commit (&UndiPrivateData->NicInfo.Hw) != E1000_SUCCESS) {
+    return EFI_DEVICE_ERROR;
+  }
+  return EFI_SUCCESS;
+}
+
+/** Drops NVM write transaction - discards staged words and brings the link
+   back to the configuration it had when the transaction was opened
+
+   @param[in]   UndiPrivateData   Pointer to driver private data structure
+
+   @retval      EFI_SUCCESS       Transaction dropped
+**/
+EFI_STATUS
+AbortNvmTransaction (
+  IN  UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  struct e1000_hw *Hw;
+
+  Hw = &UndiPrivateData->NicInfo.Hw;
+
+  if (Hw->nvm.txn.depth == 0) {
+    return EFI_SUCCESS;
+  }
+
+  e1000_nvm_txn_abort (Hw);
+
+  if ((Hw->mac.autoneg != UndiPrivateData->HiiInfo.TxnAutoneg)
+    || (Hw->mac.forced_speed_duplex != UndiPrivateData->HiiInfo.TxnForcedSpeedDuplex))
+  {
+    DEBUGPRINT (HII, ("Restoring link setting of the dropped transaction\n"));
+    Hw->mac.autoneg             = UndiPrivateData->HiiInfo.TxnAutoneg;
+    Hw->mac.forced_speed_duplex = UndiPrivateData->HiiInfo.TxnForcedSpeedDuplex;
+    RestartLink (UndiPrivateData);
+  }
+
+  return EFI_SUCCESS;
+}
+
@@ -313,5 +313,39 @@ UpdateNvmChecksum (
   IN  UNDI_PRIVATE_DATA *UndiPrivateData
   );
 
+/** Opens NVM write transaction. Until it is committed NVM writes are staged
+   and checksum updates deferred, so a batch of changes costs one commit.
+
+   @param[in]   UndiPrivateData   Pointer to driver private data structure
+**/
+VOID
+BeginNvmTransaction (
+  IN  UNDI_PRIVATE_DATA *UndiPrivateData
+  );
+
+/** Commits NVM write transaction - writes staged words and updates checksum once
+
+   @param[in]   UndiPrivateData   Pointer to driver private data structure
+
+   @retval      EFI_SUCCESS       Transaction committed
+   @retval      EFI_DEVICE_ERROR  Failed to write NVM or update its checksum
+**/
+EFI_STATUS
+CommitNvmTransaction (
+  IN  UNDI_PRIVATE_DATA *UndiPrivateData
+  );
+
+/** Drops NVM write transaction - discards staged words and brings the link
+   back to the configuration it had when the transaction was opened
+
+   @param[in]   UndiPrivateData   Pointer to driver private data structure
+
+   @retval      EFI_SUCCESS       Transaction dropped
+**/
+EFI_STATUS
+AbortNvmTransaction (
+  IN  UNDI_PRIVATE_DATA *UndiPrivateData
+  );
+
 
 #endif /* EEPROM_CONFIG_H_ */
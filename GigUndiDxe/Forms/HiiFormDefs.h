@@ -60,6 +60,9 @@
 #define     QUESTION_ID_DEFAULT_WOL                             0x100D
 #define     QUESTION_ID_LLDP_AGENT                              0x100E
 #define     QUESTION_ID_LLDP_AGENT_DEAULT                       0x100F
+#define     QUESTION_ID_RX_DROP_POLICY                          0x1010
+#define     QUESTION_ID_SFP_MODULE                              0x1011
+#define     QUESTION_ID_PACKET_BUFFER_PROFILE                   0x1012
 
 
 /* Values used to fill formset variables */
@@ -92,6 +95,13 @@
 #define WOL_ENABLE                            0x01
 #define WOL_NA                                0x02
 
+#define RX_DROP_POLICY_DISABLED               0x00
+#define RX_DROP_POLICY_CONTROL                0x01
+#define RX_DROP_POLICY_STRICT                 0x02
+
+#define PACKET_BUFFER_PROFILE_STANDARD        0x00
+#define PACKET_BUFFER_PROFILE_RX              0x01
+
 
 
 
@@ -28,7 +28,348 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #include "E1000.h"
 
-HEALTH_MSG_ENTRY mDriverHealthEntry[] = { {0, NULL} };
+/* Sampling period of the health monitor, in 100 ns units */
+#define HEALTH_SAMPLE_PERIOD          10000000
+
+/* Number of samples a condition stays reported after it was last seen */
+#define HEALTH_HOLD_SAMPLES           30
+
+/* Per sample thresholds, a counter has to pass both the count and the ratio
+   (against good frames plus the counter itself) to raise its condition */
+#define HEALTH_RX_NO_BUFFER_MIN       64
+#define HEALTH_RX_NO_BUFFER_PERMILLE  50
+#define HEALTH_RX_MISSED_MIN          16
+#define HEALTH_RX_MISSED_PERMILLE     10
+#define HEALTH_RX_ERRORS_MIN          8
+#define HEALTH_RX_ERRORS_PERMILLE     1
+#define HEALTH_RX_ERRORS_HIGH_MIN     64
+#define HEALTH_RX_ERRORS_HIGH_PERMILLE 10
+
+/* Link losses inside one hold window, the first loss is usually our own reset */
+#define HEALTH_LINK_FLAP_LOSSES       2
+#define HEALTH_LINK_FLAP_HIGH_LOSSES  4
+
+/* Indexed by HEALTH_CONDITION_xxx bit number */
+HEALTH_MSG_ENTRY mDriverHealthEntry[] = {
+  { STRING_TOKEN (STR_RX_NO_BUFFER_HEALTH_MESSAGE),  "Receive descriptors are running out, frames are being delayed or dropped.", TRUE },
+  { STRING_TOKEN (STR_RX_MISSED_HEALTH_MESSAGE),     "Receive packet buffer overflowed, frames were missed.", TRUE },
+  { STRING_TOKEN (STR_RX_ERRORS_HEALTH_MESSAGE),     "Receive CRC or alignment errors detected. Check the cable and link partner.", TRUE },
+  { STRING_TOKEN (STR_RX_ERRORS_HIGH_HEALTH_MESSAGE), "High rate of receive CRC or alignment errors. Replace the cable or check the link partner.", FALSE },
+  { STRING_TOKEN (STR_DOWNSHIFT_HEALTH_MESSAGE),     "Link is running below 1000 Mbps although 1000 Mbps is advertised. Check the cable.", TRUE },
+  { STRING_TOKEN (STR_HALF_DUPLEX_HEALTH_MESSAGE),   "Link is running at half duplex. Check the link partner configuration.", TRUE },
+  { STRING_TOKEN (STR_COLLISIONS_HEALTH_MESSAGE),    "Frames dropped after excessive collisions.", TRUE },
+  { STRING_TOKEN (STR_LINK_FLAP_HEALTH_MESSAGE),     "Link was lost repeatedly.", TRUE },
+  { STRING_TOKEN (STR_LINK_FLAP_HIGH_HEALTH_MESSAGE), "Link is flapping. Check the cable and link partner.", FALSE }
+};
+
+STATIC_ASSERT (
+  sizeof (mDriverHealthEntry) / sizeof (mDriverHealthEntry[0]) == HEALTH_CONDITION_COUNT,
+  "mDriverHealthEntry must have one entry per health condition"
+  );
+
+/** Tells whether a per sample counter delta passes its thresholds.
+
+   @param[in]   Delta      Counter increase since the previous sample
+   @param[in]   Good       Good frames received since the previous sample
+   @param[in]   Min        Minimum Delta
+   @param[in]   PerMille   Minimum Delta per thousand of Good + Delta
+
+   @retval   TRUE    Threshold exceeded
+   @retval   FALSE   Counter is within limits
+**/
+STATIC
+BOOLEAN
+HealthThresholdExceeded (
+  IN  UINT32  Delta,
+  IN  UINT32  Good,
+  IN  UINT32  Min,
+  IN  UINT32  PerMille
+  )
+{
+  return (BOOLEAN) ((Delta >= Min)
+                 && (MultU64x32 (Delta, 1000) >= MultU64x32 ((UINT64) Good + Delta, PerMille)));
+}
+
+/** Samples the adapter counters and link state and updates the reported conditions.
+
+   Statistics registers clear on read, so everything read here is also added
+   to the UNDI statistics the same way E1000Statistics() does it.
+
+   @param[in]   UndiPrivateData   Driver private data structure
+**/
+STATIC
+VOID
+HealthSample (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData
+  )
+{
+  HEALTH_MONITOR         *Health;
+  ADAPTER_INFO_HEALTH    *Info;
+  struct e1000_hw        *Hw;
+  struct e1000_hw_stats  *St;
+  UINT32                 Raised;
+  UINT32                 StatusReg;
+  UINT32                 AlignErrors;
+  UINT32                 RxGood;
+  UINT32                 TxGood;
+  UINT32                 RxNoBuffer;
+  UINT32                 RxMissed;
+  UINT32                 RxErrors;
+  UINT32                 Ecol;
+  BOOLEAN                LinkUp;
+  UINTN                  i;
+
+  Health  = &UndiPrivateData->Health;
+  Info    = &Health->Info;
+  Hw      = &UndiPrivateData->NicInfo.Hw;
+  St      = &UndiPrivateData->NicInfo.Cold->Stats;
+  Raised  = 0;
+
+  StatusReg = E1000_READ_REG (Hw, E1000_STATUS);
+  if (StatusReg == INVALID_STATUS_REGISTER_VALUE) {
+    return;
+  }
+
+  RxGood      = E1000_READ_REG (Hw, E1000_GPRC);
+  TxGood      = E1000_READ_REG (Hw, E1000_GPTC);
+  RxNoBuffer  = E1000_READ_REG (Hw, E1000_RNBC);
+  RxMissed    = E1000_READ_REG (Hw, E1000_MPC);
+  RxErrors    = E1000_READ_REG (Hw, E1000_CRCERRS);
+  AlignErrors = E1000_READ_REG (Hw, E1000_ALGNERRC);
+  Ecol        = E1000_READ_REG (Hw, E1000_ECOL);
+
+  St->gprc      += RxGood;
+  St->gptc      += TxGood;
+  St->rnbc      += RxNoBuffer;
+  St->mpc       += RxMissed;
+  St->crcerrs   += RxErrors;
+  St->algnerrc  += AlignErrors;
+  St->ecol      += Ecol;
+
+  RxErrors += AlignErrors;
+
+  Info->RxGood              += RxGood;
+  Info->TxGood              += TxGood;
+  Info->RxNoBuffer          += RxNoBuffer;
+  Info->RxMissed            += RxMissed;
+  Info->RxErrors            += RxErrors;
+  Info->ExcessiveCollisions += Ecol;
+  Info->Samples++;
+
+  if (HealthThresholdExceeded (RxNoBuffer, RxGood, HEALTH_RX_NO_BUFFER_MIN, HEALTH_RX_NO_BUFFER_PERMILLE)) {
+    Raised |= HEALTH_CONDITION_RX_NO_BUFFER;
+  }
+  if (HealthThresholdExceeded (RxMissed, RxGood, HEALTH_RX_MISSED_MIN, HEALTH_RX_MISSED_PERMILLE)) {
+    Raised |= HEALTH_CONDITION_RX_MISSED;
+  }
+  if (HealthThresholdExceeded (RxErrors, RxGood, HEALTH_RX_ERRORS_MIN, HEALTH_RX_ERRORS_PERMILLE)) {
+    Raised |= HEALTH_CONDITION_RX_ERRORS;
+  }
+  if (HealthThresholdExceeded (RxErrors, RxGood, HEALTH_RX_ERRORS_HIGH_MIN, HEALTH_RX_ERRORS_HIGH_PERMILLE)) {
+    Raised |= HEALTH_CONDITION_RX_ERRORS_HIGH;
+  }
+  if (Ecol != 0) {
+    Raised |= HEALTH_CONDITION_COLLISIONS;
+  }
+
+  // Link state
+  LinkUp = (BOOLEAN) ((StatusReg & E1000_STATUS_LU) != 0);
+
+  Info->LinkSpeed   = 0;
+  Info->FullDuplex  = FALSE;
+  if (LinkUp) {
+    switch (StatusReg & E1000_STATUS_SPEED_MASK) {
+    case E1000_STATUS_SPEED_10:
+      Info->LinkSpeed = 10;
+      break;
+    case E1000_STATUS_SPEED_100:
+      Info->LinkSpeed = 100;
+      break;
+    default:
+      Info->LinkSpeed = 1000;
+      break;
+    }
+    Info->FullDuplex = (BOOLEAN) ((StatusReg & E1000_STATUS_FD) != 0);
+
+    if (!Info->FullDuplex) {
+      Raised |= HEALTH_CONDITION_HALF_DUPLEX;
+    }
+
+    if ((Info->LinkSpeed < 1000)
+      && (Hw->phy.media_type == e1000_media_type_copper)
+      && Hw->mac.autoneg
+      && ((Hw->phy.autoneg_advertised & ADVERTISE_1000_FULL) != 0))
+    {
+      Raised |= HEALTH_CONDITION_LINK_DOWNSHIFT;
+    }
+  }
+
+  if (Health->LinkKnown
+    && Health->LinkUp
+    && !LinkUp)
+  {
+    Info->LinkLosses++;
+    Health->SamplesSinceLoss = 0;
+  } else if (Health->SamplesSinceLoss < HEALTH_HOLD_SAMPLES) {
+    Health->SamplesSinceLoss++;
+  } else {
+    Info->LinkLosses = 0;
+  }
+
+  Health->LinkKnown = TRUE;
+  Health->LinkUp    = LinkUp;
+
+  if (Info->LinkLosses >= HEALTH_LINK_FLAP_LOSSES) {
+    Raised |= HEALTH_CONDITION_LINK_FLAP;
+  }
+  if (Info->LinkLosses >= HEALTH_LINK_FLAP_HIGH_LOSSES) {
+    Raised |= HEALTH_CONDITION_LINK_FLAP_HIGH;
+  }
+
+  // Conditions stay reported for HEALTH_HOLD_SAMPLES after they were last seen
+  Info->Conditions = 0;
+  for (i = 0; i < HEALTH_CONDITION_COUNT; i++) {
+    if ((Raised & (1 << i)) != 0) {
+      Health->Hold[i] = HEALTH_HOLD_SAMPLES;
+    } else if (Health->Hold[i] > 0) {
+      Health->Hold[i]--;
+    }
+
+    if (Health->Hold[i] > 0) {
+      Info->Conditions |= (1 << i);
+    }
+  }
+
+  if (Raised != 0) {
+    DEBUGPRINT (HEALTH, ("Health conditions raised %x, reported %x\n", Raised, Info->Conditions));
+  }
+}
+
+/** Timer notification, takes one health sample.
+
+   @param[in]   Event     Sampling timer event
+   @param[in]   Context   Driver private data structure
+**/
+STATIC
+VOID
+EFIAPI
+HealthSampleNotify (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  UNDI_PRIVATE_DATA  *UndiPrivateData;
+
+  UndiPrivateData = (UNDI_PRIVATE_DATA *) Context;
+
+  if (mExitBootServicesTriggered
+    || UndiPrivateData->Health.Paused
+    || UndiPrivateData->NicInfo.SurpriseRemoval)
+  {
+    return;
+  }
+
+  HealthSample (UndiPrivateData);
+}
+
+/** Takes a first health sample and starts periodic sampling of the adapter.
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval  EFI_SUCCESS   Sampling started
+   @retval  !EFI_SUCCESS  Failed to create or arm the sampling timer
+**/
+EFI_STATUS
+HealthMonitorStart (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData
+  )
+{
+  HEALTH_MONITOR  *Health;
+  EFI_STATUS      Status;
+
+  Health = &UndiPrivateData->Health;
+
+  if (Health->Event != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  ZeroMem (Health, sizeof (HEALTH_MONITOR));
+  Health->Info.SamplePeriodMs = HEALTH_SAMPLE_PERIOD / 10000;
+
+  HealthSample (UndiPrivateData);
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  HealthSampleNotify,
+                  UndiPrivateData,
+                  &Health->Event
+                );
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("CreateEvent returns %r\n", Status));
+    Health->Event = NULL;
+    return Status;
+  }
+
+  Status = gBS->SetTimer (Health->Event, TimerPeriodic, HEALTH_SAMPLE_PERIOD);
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("SetTimer returns %r\n", Status));
+    gBS->CloseEvent (Health->Event);
+    Health->Event = NULL;
+  }
+
+  return Status;
+}
+
+/** Stops periodic sampling of the adapter.
+
+   @param[in]   UndiPrivateData   Driver private data structure
+**/
+VOID
+HealthMonitorStop (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData
+  )
+{
+  if (UndiPrivateData->Health.Event != NULL) {
+    gBS->CloseEvent (UndiPrivateData->Health.Event);
+    UndiPrivateData->Health.Event = NULL;
+  }
+}
+
+/** Holds off sampling while the driver itself takes the link down.
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @return   Paused state on entry, to be passed to HealthMonitorResume()
+**/
+BOOLEAN
+HealthMonitorPause (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData
+  )
+{
+  BOOLEAN  WasPaused;
+
+  WasPaused = UndiPrivateData->Health.Paused;
+  UndiPrivateData->Health.Paused = TRUE;
+
+  return WasPaused;
+}
+
+/** Resumes sampling after HealthMonitorPause(). The link state seen before
+   the pause is dropped, so the driver's own link drop is not a link loss.
+
+   @param[in]   UndiPrivateData   Driver private data structure
+   @param[in]   WasPaused         Value returned by HealthMonitorPause()
+**/
+VOID
+HealthMonitorResume (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData,
+  IN  BOOLEAN            WasPaused
+  )
+{
+  UndiPrivateData->Health.LinkKnown = FALSE;
+  UndiPrivateData->Health.Paused    = WasPaused;
+}
 
 
 /** Retrieves adapter specific health status information from SW/FW/HW.
@@ -47,9 +388,19 @@ GetAdapterHealthStatus (
   OUT  UINT16             *ErrorIndexes
   )
 {
+  UINT32  Conditions;
+  UINT16  i;
+
   ASSERT (ErrorCount != NULL);
 
-  *ErrorCount = 0; // E1000 driver always reports being healthy
+  *ErrorCount = 0;
+  Conditions  = UndiPrivateData->Health.Info.Conditions;
+
+  for (i = 0; i < HEALTH_CONDITION_COUNT; i++) {
+    if ((Conditions & (1 << i)) != 0) {
+      AddHealthError (ErrorCount, ErrorIndexes, i);
+    }
+  }
 
   return EFI_SUCCESS;
 }
@@ -81,6 +81,151 @@ GetVarStoreMapCfg (
   return NULL;
 }
 
+/** Runs driver PrepareAccess hook (if defined) before Config Access protocol operation.
+  Failure is only logged - the operation itself can still be served.
+
+  @param[in]  CfgAccessInfo  Pointer to HII_CFG_ACCESS_INFO structure
+**/
+VOID
+PrepareConfigAccess (
+  IN  HII_CFG_ACCESS_INFO  *CfgAccessInfo
+  )
+{
+  EFI_STATUS  Status;
+
+  if (CfgAccessInfo->PrepareAccess != NULL) {
+    Status = CfgAccessInfo->PrepareAccess (CfgAccessInfo->CallBackDriverContext);
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("PrepareAccess failed with %r\n", Status));
+    }
+  }
+}
+
+/** Drops all field values stored in varstore snapshot.
+
+  @param[in,out]  VarStoreMapCfg  HII varstore map configuration structure
+**/
+VOID
+InvalidateVarStoreSnapshot (
+  IN OUT  HII_VARSTORE_MAP_CFG  *VarStoreMapCfg
+  )
+{
+  if (VarStoreMapCfg->SnapshotState != NULL) {
+    ZeroMem (VarStoreMapCfg->SnapshotState, VarStoreMapCfg->NumMapEntries);
+  }
+}
+
+/** Prepares varstore snapshot for use in current ExtractConfig/RouteConfig call. Allocates
+  snapshot on first use and drops its contents when driver configuration epoch has changed.
+
+  @param[in,out]  VarStoreMapCfg  HII varstore map configuration structure
+
+  @retval  TRUE   Snapshot is up to date and can be used
+  @retval  FALSE  Snapshot is not available, getters have to be called
+**/
+BOOLEAN
+SyncVarStoreSnapshot (
+  IN OUT  HII_VARSTORE_MAP_CFG  *VarStoreMapCfg
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Epoch;
+
+  if (VarStoreMapCfg->GetEpoch == NULL) {
+    return FALSE;
+  }
+
+  Status = VarStoreMapCfg->GetEpoch (VarStoreMapCfg->DriverContext, &Epoch);
+  if (EFI_ERROR (Status)) {
+    InvalidateVarStoreSnapshot (VarStoreMapCfg);
+    return FALSE;
+  }
+
+  if (VarStoreMapCfg->Snapshot == NULL) {
+    VarStoreMapCfg->Snapshot      = AllocateZeroPool (VarStoreMapCfg->ConfigSize);
+    VarStoreMapCfg->SnapshotState = AllocateZeroPool (VarStoreMapCfg->NumMapEntries);
+    if ((VarStoreMapCfg->Snapshot == NULL) ||
+        (VarStoreMapCfg->SnapshotState == NULL))
+    {
+      DEBUGPRINT (CRITICAL, ("Failed to allocate varstore snapshot!\n"));
+      if (VarStoreMapCfg->Snapshot != NULL) {
+        FreePool (VarStoreMapCfg->Snapshot);
+        VarStoreMapCfg->Snapshot = NULL;
+      }
+      if (VarStoreMapCfg->SnapshotState != NULL) {
+        FreePool (VarStoreMapCfg->SnapshotState);
+        VarStoreMapCfg->SnapshotState = NULL;
+      }
+      return FALSE;
+    }
+  } else if (Epoch != VarStoreMapCfg->SnapshotEpoch) {
+    DEBUGPRINT (HII, ("Config epoch %d -> %d, dropping snapshot\n", VarStoreMapCfg->SnapshotEpoch, Epoch));
+    InvalidateVarStoreSnapshot (VarStoreMapCfg);
+  }
+
+  VarStoreMapCfg->SnapshotEpoch = Epoch;
+  return TRUE;
+}
+
+/** Releases varstore snapshots of all varstore map configs.
+
+  @param[in,out]  CfgAccessInfo  Pointer to HII_CFG_ACCESS_INFO structure
+**/
+VOID
+FreeVarStoreSnapshots (
+  IN OUT  HII_CFG_ACCESS_INFO  *CfgAccessInfo
+  )
+{
+  HII_VARSTORE_MAP_CFG  *VarStoreMapCfg;
+
+  if (CfgAccessInfo->VarStoreConfigs == NULL) {
+    return;
+  }
+
+  for (UINTN i = 0; i < CfgAccessInfo->NumberOfVarStoreConfigs; i++) {
+    VarStoreMapCfg = &CfgAccessInfo->VarStoreConfigs[i];
+    if (VarStoreMapCfg->Snapshot != NULL) {
+      FreePool (VarStoreMapCfg->Snapshot);
+      VarStoreMapCfg->Snapshot = NULL;
+    }
+    if (VarStoreMapCfg->SnapshotState != NULL) {
+      FreePool (VarStoreMapCfg->SnapshotState);
+      VarStoreMapCfg->SnapshotState = NULL;
+    }
+  }
+}
+
+/** Stores extracted field in varstore snapshot (if snapshot is in use).
+
+  @param[in,out]  VarStoreMapCfg  HII varstore map configuration structure
+  @param[in]      MapIdx          Index of config map entry
+  @param[in]      ConfigMapEntry  Pointer to the specific config map entry
+  @param[in]      HiiConfigData   Varstore raw buffer address
+  @param[in]      State           HII_SNAPSHOT_xx state to record
+**/
+VOID
+SaveFieldSnapshot (
+  IN OUT  HII_VARSTORE_MAP_CFG  *VarStoreMapCfg,
+  IN      UINTN                 MapIdx,
+  IN      HII_CONFIG_MAP_ENTRY  *ConfigMapEntry,
+  IN      UINT8                 *HiiConfigData,
+  IN      UINT8                 State
+  )
+{
+  if (VarStoreMapCfg->SnapshotState == NULL) {
+    return;
+  }
+
+  if (State == HII_SNAPSHOT_VALUE) {
+    CopyMem (
+      VarStoreMapCfg->Snapshot + ConfigMapEntry->FieldOffset,
+      HiiConfigData + ConfigMapEntry->FieldOffset,
+      ConfigMapEntry->FieldWidth
+      );
+  }
+  VarStoreMapCfg->SnapshotState[MapIdx] = State;
+}
+
 /** Gets HII varstore map configuration structure for given Configuration or Request string.
 
   @param[in]   VarStoreMapCfg    HII varstore map configuration structure
@@ -193,6 +338,7 @@ EvaluateSupportFlags (
 }
 
 /** Extracts configuration bytes of <ElementOffset, ElementOffset+ElementWidth) to varstore.
+  Fields already present in varstore snapshot are copied from it without calling getters.
 
   @param[in]   VarStoreMapCfg  HII varstore map configuration structure
   @param[out]  HiiConfigData   Varstore raw buffer address
@@ -216,6 +362,7 @@ ExtractConfigRange (
   FIELD_SUPPORT         Support;
   UINTN                 CurrentOffset;
   UINTN                 EndRangeOffset;
+  UINT8                 SnapshotState;
   EFI_STATUS            Status;
 
   ASSERT_IF_NULL2 (VarStoreMapCfg, HiiConfigData);
@@ -238,7 +385,20 @@ ExtractConfigRange (
         DEBUGPRINT (HII, ("Field name: %a \n", ConfigMapEntry->Name));
 #endif /* DBG_LVL & HII */
         if (!ConfigMapEntry->CfgExecuted) {
-          if (ConfigMapEntry->Get != NULL) {
+          SnapshotState = (VarStoreMapCfg->SnapshotState != NULL) ?
+                          VarStoreMapCfg->SnapshotState[MapIdx] : HII_SNAPSHOT_EMPTY;
+
+          if (SnapshotState == HII_SNAPSHOT_VALUE) {
+            CopyMem (
+              HiiConfigData + ConfigMapEntry->FieldOffset,
+              VarStoreMapCfg->Snapshot + ConfigMapEntry->FieldOffset,
+              ConfigMapEntry->FieldWidth
+              );
+            DEBUGPRINT (HII, ("Extracted element from snapshot\n"));
+            ConfigMapEntry->CfgExecuted = TRUE;
+          } else if (SnapshotState == HII_SNAPSHOT_SUPPRESSED) {
+            DEBUGPRINT (HII, ("Element suppressed in snapshot\n"));
+          } else if (ConfigMapEntry->Get != NULL) {
             Status = EvaluateMapEntrySupport (VarStoreMapCfg, ConfigMapEntry, &Support);
             IF_RETURN (EFI_ERROR (Status), Status);
 
@@ -247,6 +407,9 @@ ExtractConfigRange (
               IF_RETURN (EFI_ERROR (Status), Status);
               DEBUGPRINT (HII, ("Extracted element\n"));
               ConfigMapEntry->CfgExecuted = TRUE;
+              SaveFieldSnapshot (VarStoreMapCfg, MapIdx, ConfigMapEntry, HiiConfigData, HII_SNAPSHOT_VALUE);
+            } else {
+              SaveFieldSnapshot (VarStoreMapCfg, MapIdx, ConfigMapEntry, HiiConfigData, HII_SNAPSHOT_SUPPRESSED);
             }
           } else if (VarStoreMapCfg->HasSupportTable &&
                     (ConfigMapEntry->FieldOffset == VarStoreMapCfg->SupportTableOffset))
@@ -254,6 +417,7 @@ ExtractConfigRange (
             Status = EvaluateSupportFlags (VarStoreMapCfg, HiiConfigData + VarStoreMapCfg->SupportTableOffset);
             IF_RETURN (EFI_ERROR (Status), Status);
             ConfigMapEntry->CfgExecuted = TRUE;
+            SaveFieldSnapshot (VarStoreMapCfg, MapIdx, ConfigMapEntry, HiiConfigData, HII_SNAPSHOT_VALUE);
           }
         }
         CurrentOffset += ConfigMapEntry->FieldWidth - 1; // -1 due to ++ after break
@@ -405,6 +569,8 @@ RouteConfigRange (
             IF_RETURN (EFI_ERROR (Status), Status);
             if (Support == MODIFIABLE) {
               Status = ConfigMapEntry->Set (VarStoreMapCfg->DriverContext, HiiConfigData + ConfigMapEntry->FieldOffset);
+              // Setter may affect any other field, don't compare against stale values
+              InvalidateVarStoreSnapshot (VarStoreMapCfg);
               IF_RETURN (EFI_ERROR (Status), Status);
               DEBUGPRINT (HII, ("Routed element\n"));
               DEBUGWAIT (HII);
@@ -712,6 +878,7 @@ ExtractConfig (
   *Progress = Request;
 
   CfgAccessInfo = HII_CFG_ACCESS_INFO_FROM_HII_CONFIG_ACCESS_PROT (This);
+  PrepareConfigAccess (CfgAccessInfo);
 
   VarStoreMapCfg = GetVarStoreMapCfg (CfgAccessInfo, Request);
   IF_NULL_RETURN (VarStoreMapCfg, EFI_NOT_FOUND);
@@ -761,6 +928,8 @@ ExtractConfig (
     ConfigMapEntry->CfgExecuted = FALSE;
   }
 
+  SyncVarStoreSnapshot (VarStoreMapCfg);
+
   if (VarStoreMapCfg->PreExtract != NULL) {
     Status = VarStoreMapCfg->PreExtract (VarStoreMapCfg->DriverContext, HiiConfigData, Request);
     IF_GOTO (EFI_ERROR (Status), ExitExtractError);
@@ -859,6 +1028,7 @@ RouteConfig (
   EFI_STRING            ConfigElement     = NULL;
   UINTN                 ElementOffset     = 0;
   UINTN                 ElementWidth      = 0;
+  BOOLEAN               RouteStarted      = FALSE;
 
   IF_NULL3_RETURN (This, Configuration, Progress, EFI_INVALID_PARAMETER);
 
@@ -868,6 +1038,7 @@ RouteConfig (
   *Progress = Configuration;
 
   CfgAccessInfo = HII_CFG_ACCESS_INFO_FROM_HII_CONFIG_ACCESS_PROT (This);
+  PrepareConfigAccess (CfgAccessInfo);
 
   VarStoreMapCfg = GetVarStoreMapCfg (CfgAccessInfo, Configuration);
   IF_NULL_RETURN (VarStoreMapCfg, EFI_NOT_FOUND);
@@ -897,10 +1068,13 @@ RouteConfig (
     ConfigMapEntry->CfgExecuted = FALSE;
   }
 
+  SyncVarStoreSnapshot (VarStoreMapCfg);
+
   if (VarStoreMapCfg->PreRoute != NULL) {
     Status = VarStoreMapCfg->PreRoute (VarStoreMapCfg->DriverContext, HiiConfigData, Configuration);
     IF_GOTO (EFI_ERROR (Status), ExitRouteError);
   }
+  RouteStarted = TRUE;
 
   while (*ConfigElement != L'\0') {
 
@@ -929,6 +1103,16 @@ RouteConfig (
   }
 
 ExitRouteError:
+  // Let the driver drop anything PreRoute and the setters left half done
+  if (EFI_ERROR (Status) && RouteStarted && (VarStoreMapCfg->AbortRoute != NULL)) {
+    VarStoreMapCfg->AbortRoute (VarStoreMapCfg->DriverContext);
+  }
+
+  // Next ExtractConfig has to show configuration as left by this RouteConfig
+  if (RouteStarted) {
+    InvalidateVarStoreSnapshot (VarStoreMapCfg);
+  }
+
   if (HiiConfigData != NULL) {
     FreePool (HiiConfigData);
   }
@@ -975,6 +1159,7 @@ CallBack (
   CfgAccessInfo   = HII_CFG_ACCESS_INFO_FROM_HII_CONFIG_ACCESS_PROT (This);
   CallBackContext = CfgAccessInfo->CallBackDriverContext;
   ASSERT (CallBackContext != NULL);
+  PrepareConfigAccess (CfgAccessInfo);
 
   *ActionRequest = EFI_BROWSER_ACTION_REQUEST_NONE;
 
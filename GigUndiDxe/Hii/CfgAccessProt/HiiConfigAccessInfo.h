@@ -137,6 +137,29 @@ EFI_STATUS
   OUT  FIELD_SUPPORT  *SupportTable
   );
 
+/** Returns configuration epoch of the driver instance (OPTIONAL). Varstore snapshot taken
+   in given epoch is reused by ExtractConfig until the epoch changes, so the driver has
+   to move to a new epoch whenever a getter or support check could return a different value.
+
+   @param[in]   DriverContext    Pointer to driver private data structure
+   @param[out]  Epoch            Current configuration epoch
+
+   @retval      EFI_SUCCESS      Operation successful.
+   @retval      !EFI_SUCCESS     Failure with reason specific to varstore config map
+**/
+typedef
+EFI_STATUS
+(*HII_CONFIG_GET_EPOCH) (
+  IN   VOID    *DriverContext,
+  OUT  UINT32  *Epoch
+  );
+
+/** Varstore snapshot state of single config map entry.
+**/
+#define HII_SNAPSHOT_EMPTY       0 ///< field not extracted in current epoch
+#define HII_SNAPSHOT_VALUE       1 ///< field value stored in snapshot
+#define HII_SNAPSHOT_SUPPRESSED  2 ///< field suppressed, getter not called
+
 /** Structure which describes single varstore configuration map.
 **/
 typedef struct HII_VARSTORE_MAP_CFG_S {
@@ -153,11 +176,20 @@ typedef struct HII_VARSTORE_MAP_CFG_S {
   HII_CONFIG_POST_EXTRACT_ROUTE        PostExtract;
   HII_CONFIG_PRE_EXTRACT_ROUTE         PreRoute;
   HII_CONFIG_POST_EXTRACT_ROUTE        PostRoute;
+  HII_CONFIG_POST_EXTRACT_ROUTE        AbortRoute;   ///< called instead of PostRoute when RouteConfig fails after PreRoute
 
   // Optional function, can be NULL, see typedef description
   HII_EVAL_UNAFFILIATED_SUPPORT_FLAGS  EvalUnaffiliatedSupport;
 
+  // Optional function, can be NULL - then every ExtractConfig calls the getters
+  HII_CONFIG_GET_EPOCH                 GetEpoch;
+
   VOID                                 *DriverContext;
+
+  // Per driver instance varstore snapshot, maintained by HiiConfigAccess.c
+  UINT8                                *Snapshot;      ///< Varstore contents extracted in SnapshotEpoch
+  UINT8                                *SnapshotState; ///< HII_SNAPSHOT_xx value for each config map entry
+  UINT32                               SnapshotEpoch;
 } HII_VARSTORE_MAP_CFG;
 
 #define HII_CFG_ACCESS_INFO_SIG SIGNATURE_32 ('H', 'C', 'I', 'S')
@@ -183,6 +215,20 @@ EFI_STATUS
   OUT    EFI_BROWSER_ACTION_REQUEST  *ActionRequest
   );
 
+/** Called on entry to every Config Access protocol function, before any varstore
+   or callback processing. Lets driver defer work until HII content is actually used.
+
+   @param[in]      DriverContext    Pointer to driver private data structure
+
+   @retval      EFI_SUCCESS      Operation successful.
+   @retval      !EFI_SUCCESS     Failure with reason specific to driver (logged only)
+**/
+typedef
+EFI_STATUS
+(* HII_ACCESS_PREPARE) (
+  IN     VOID                        *DriverContext
+  );
+
 /** Structure which describes whole HII Config Access protocol accessible configuration
  * supported by this driver (all varstores).
 **/
@@ -212,7 +258,19 @@ typedef struct HII_CFG_ACCESS_INFO_S {
   HII_ACCESS_FORM_ACTION_CALLBACK  OnActionDefaultHardware;
   HII_ACCESS_FORM_ACTION_CALLBACK  OnActionDefaultFirmware;
 
+  // Called before every ExtractConfig/RouteConfig/CallBack. Can be NULL.
+  HII_ACCESS_PREPARE               PrepareAccess;
+
   VOID                             *CallBackDriverContext; ///< Driver context to be used in callback
 } HII_CFG_ACCESS_INFO;
 
+/** Releases varstore snapshots of all varstore map configs.
+
+  @param[in,out]  CfgAccessInfo  Pointer to HII_CFG_ACCESS_INFO structure
+**/
+VOID
+FreeVarStoreSnapshots (
+  IN OUT  HII_CFG_ACCESS_INFO  *CfgAccessInfo
+  );
+
 #endif /* HII_CONFIG_ACCESS_INFO_H_ */
\ No newline at end of file
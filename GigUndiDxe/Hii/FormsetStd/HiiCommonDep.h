@@ -58,6 +58,33 @@ HiiConfigMapPostRoute (
   IN UNDI_PRIVATE_DATA *UndiPrivateData
   );
 
+/** Performs cleanup when standard formset RouteConfig() fails after PreRoute.
+
+   @param[in]   UndiPrivateData  Pointer to driver private data structure
+
+   @retval      EFI_SUCCESS      Operation successful
+   @retval      !EFI_SUCCESS     NVM checksum restore failed
+**/
+EFI_STATUS
+HiiConfigMapAbortRoute (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  );
+
+/** Returns configuration epoch for standard formset varstore snapshot. Epoch moves on
+   whenever NVM has been written or link state has changed since it was last queried.
+
+   @param[in]   UndiPrivateData  Pointer to driver private data structure
+   @param[out]  Epoch            Current configuration epoch
+
+   @retval      EFI_SUCCESS      Operation successful
+   @retval      !EFI_SUCCESS     Failed to get link status
+**/
+EFI_STATUS
+HiiConfigMapGetEpoch (
+  IN   UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT  UINT32             *Epoch
+  );
+
 /** HII on action changing callback - validates values passed to forms by user.
 
    @param[in]      UndiPrivateData  Pointer to driver private data structure
@@ -134,6 +161,62 @@ GetAltMacAddr (
   OUT  UINT16             *AltMacAddrUni
   );
 
+/** Gets receive drop policy of the port.
+
+  @param[in]   UndiPrivateData       Pointer to driver private data structure
+  @param[out]  RxDropPolicy          Receive drop policy
+
+  @retval     EFI_SUCCESS            Operation successful
+**/
+EFI_STATUS
+GetRxDropPolicy (
+  IN   UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT  UINT8              *RxDropPolicy
+  );
+
+/** Sets receive drop policy of the port.
+
+  @param[in]   UndiPrivateData       Pointer to driver private data structure
+  @param[in]   RxDropPolicy          Receive drop policy
+
+  @retval     EFI_SUCCESS            Operation successful
+  @retval     EFI_INVALID_PARAMETER  Unknown policy
+  @retval     !EFI_SUCCESS           Failed to store the policy
+**/
+EFI_STATUS
+SetRxDropPolicy (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData,
+  IN  UINT8              *RxDropPolicy
+  );
+
+/** Gets packet buffer profile of the port.
+
+  @param[in]   UndiPrivateData       Pointer to driver private data structure
+  @param[out]  PacketBufferProfile   Packet buffer profile
+
+  @retval     EFI_SUCCESS            Operation successful
+**/
+EFI_STATUS
+GetPacketBufferProfile (
+  IN   UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT  UINT8              *PacketBufferProfile
+  );
+
+/** Sets packet buffer profile of the port.
+
+  @param[in]   UndiPrivateData       Pointer to driver private data structure
+  @param[in]   PacketBufferProfile   Packet buffer profile
+
+  @retval     EFI_SUCCESS            Operation successful
+  @retval     EFI_INVALID_PARAMETER  Unknown profile
+  @retval     !EFI_SUCCESS           Failed to store the profile
+**/
+EFI_STATUS
+SetPacketBufferProfile (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData,
+  IN  UINT8              *PacketBufferProfile
+  );
+
 
 
 
@@ -323,6 +406,19 @@ IsAltMacAddrSupported (
   OUT  BOOLEAN            *Supported
   );
 
+/** Checks if packet buffer profile attribute is supported.
+
+  @param[in]   UndiPrivateData  Pointer to driver private data structure
+  @param[out]  Supported        BOOLEAN support information
+
+  @retval    EFI_SUCCESS        Operation successful
+**/
+EFI_STATUS
+IsPacketBufferProfileSupported (
+  IN   UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT  BOOLEAN            *Supported
+  );
+
 
 
 
@@ -41,6 +41,7 @@
 #define  LLDP_AGENT        3
 #define  LINK_SPEED_STATUS 4
 #define  ALT_MAC           6
+#define  PKT_BUF_PROFILE   7
 #define  VIS_IDX_NUM       25    // *!! MUST BE !!* equal to last #define above + 1 == No. of Support indexes
 
 #define  VIS_NO_EVAL       0xFFFFFFFF // indicates there's no Support Flag index associated with the field
@@ -53,6 +54,8 @@ typedef struct HII_STD_VARSTORE_S {
   UINT8   LinkSpeed;
   UINT8   WolStatus;
   UINT8   DefaultWolStatus;
+  UINT8   RxDropPolicy;
+  UINT8   PacketBufferProfile;
 
 
 
@@ -49,6 +49,8 @@ HII_CONFIG_MAP_ENTRY  mHiiConfigMap[] = {
   { OFFSET_WIDTH (LinkSpeed),                  GetLinkSpeed,              SetLinkSpeed,              LINK_SPEED,        IsLinkSpeedModifiable, IsLinkSpeedSupported },
   { OFFSET_WIDTH (WolStatus),                  WolGetWakeOnLanStatus,     WolSetWakeOnLanStatus,     VIS_NO_EVAL,       IsPortOptUnChanged,    NULL },
   { OFFSET_WIDTH (DefaultWolStatus),           GetDefaultWolStatus,       NULL,                      VIS_NO_EVAL,       NULL,                  NULL },
+  { OFFSET_WIDTH (RxDropPolicy),               GetRxDropPolicy,           SetRxDropPolicy,           VIS_NO_EVAL,       NULL,                  NULL },
+  { OFFSET_WIDTH (PacketBufferProfile),        GetPacketBufferProfile,    SetPacketBufferProfile,    PKT_BUF_PROFILE,   NULL,                  IsPacketBufferProfileSupported },
 
 
 
@@ -72,7 +74,9 @@ HII_VARSTORE_MAP_CFG  mHiiStandardMapCfg = {
   .SupportTableOffset      = OFFSET_OF (HII_STD_VARSTORE, Support),
   .PreRoute                = HiiConfigMapPreRoute,
   .PostRoute               = HiiConfigMapPostRoute,
-  .EvalUnaffiliatedSupport = EvaluateUnaffiliatedSupportFlags
+  .AbortRoute              = HiiConfigMapAbortRoute,
+  .EvalUnaffiliatedSupport = EvaluateUnaffiliatedSupportFlags,
+  .GetEpoch                = HiiConfigMapGetEpoch
 };
 
 /** Performs operations before starting varstore config map processing for standard formset RouteConfig().
@@ -91,6 +95,8 @@ HiiConfigMapPreRoute (
   IN CONST EFI_STRING         Configuration
   )
 {
+  // Setters only stage their NVM writes, PostRoute commits them all at once
+  BeginNvmTransaction (UndiPrivateData);
   return EFI_SUCCESS;
 }
 
@@ -110,9 +116,67 @@ HiiConfigMapPostRoute (
   EFI_STATUS Status;
 
   Status = UpdateNvmChecksum (UndiPrivateData);
-  IF_RETURN (EFI_ERROR (Status), Status);
+  if (EFI_ERROR (Status)) {
+    AbortNvmTransaction (UndiPrivateData);
+    return Status;
+  }
 
+  Status = CommitNvmTransaction (UndiPrivateData);
+  IF_RETURN (EFI_ERROR (Status), Status);
 
   DEBUGPRINT (HII, ("RouteConfig changes commited\n"));
   return EFI_SUCCESS;
 }
+
+/** Performs cleanup when standard formset RouteConfig() fails after PreRoute.
+
+   @param[in]   UndiPrivateData  Pointer to driver private data structure
+
+   @retval      EFI_SUCCESS      Operation successful
+**/
+EFI_STATUS
+HiiConfigMapAbortRoute (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  DEBUGPRINT (HII, ("RouteConfig changes dropped\n"));
+  return AbortNvmTransaction (UndiPrivateData);
+}
+
+/** Returns configuration epoch for standard formset varstore snapshot. Epoch moves on
+   whenever NVM has been written or link state has changed since it was last queried.
+
+   @param[in]   UndiPrivateData  Pointer to driver private data structure
+   @param[out]  Epoch            Current configuration epoch
+
+   @retval      EFI_SUCCESS      Operation successful
+   @retval      !EFI_SUCCESS     Failed to get link status
+**/
+EFI_STATUS
+HiiConfigMapGetEpoch (
+  IN   UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT  UINT32             *Epoch
+  )
+{
+  HII_INFO    *HiiInfo;
+  UINT32      NvmGeneration;
+  BOOLEAN     LinkUp;
+  EFI_STATUS  Status;
+
+  HiiInfo       = &UndiPrivateData->HiiInfo;
+  NvmGeneration = UndiPrivateData->NicInfo.Hw.nvm.generation;
+
+  Status = GetLinkStatus (UndiPrivateData, &LinkUp);
+  IF_RETURN (EFI_ERROR (Status), Status);
+
+  if ((NvmGeneration != HiiInfo->EpochNvmGeneration) ||
+      (LinkUp != HiiInfo->EpochLinkUp))
+  {
+    HiiInfo->EpochNvmGeneration = NvmGeneration;
+    HiiInfo->EpochLinkUp        = LinkUp;
+    HiiInfo->ConfigEpoch++;
+  }
+
+  *Epoch = HiiInfo->ConfigEpoch;
+  return EFI_SUCCESS;
+}
@@ -44,7 +44,7 @@ GetDefaultWolStatus (
   OUT  ADAPTER_WOL_STATUS  *WolStatus
   )
 {
-  if (WolIsWakeOnLanSupported (UndiPrivateData)) {
+  if (UndiPrivateData->IsWolSupported) {
     *WolStatus = WOL_ENABLE;
   } else {
     *WolStatus = WOL_NA;
@@ -84,3 +84,37 @@ GetAltMacAddr (
   return EFI_SUCCESS;
 }
 
+/** Gets receive drop policy of the port.
+
+  @param[in]   UndiPrivateData       Pointer to driver private data structure
+  @param[out]  RxDropPolicy          Receive drop policy
+
+  @retval     EFI_SUCCESS            Operation successful
+**/
+EFI_STATUS
+GetRxDropPolicy (
+  IN   UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT  UINT8              *RxDropPolicy
+  )
+{
+  *RxDropPolicy = UndiPrivateData->NicInfo.RxDropPolicy.Policy;
+  return EFI_SUCCESS;
+}
+
+/** Gets packet buffer profile of the port.
+
+  @param[in]   UndiPrivateData       Pointer to driver private data structure
+  @param[out]  PacketBufferProfile   Packet buffer profile
+
+  @retval     EFI_SUCCESS            Operation successful
+**/
+EFI_STATUS
+GetPacketBufferProfile (
+  IN   UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT  UINT8              *PacketBufferProfile
+  )
+{
+  *PacketBufferProfile = UndiPrivateData->NicInfo.PacketBufferProfile;
+  return EFI_SUCCESS;
+}
+
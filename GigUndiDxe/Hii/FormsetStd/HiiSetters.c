@@ -27,5 +27,41 @@
 
 #include "wol.h"
 
+/** Sets receive drop policy of the port.
+
+  @param[in]   UndiPrivateData       Pointer to driver private data structure
+  @param[in]   RxDropPolicy          Receive drop policy
+
+  @retval     EFI_SUCCESS            Operation successful
+  @retval     EFI_INVALID_PARAMETER  Unknown policy
+  @retval     !EFI_SUCCESS           Failed to store the policy
+**/
+EFI_STATUS
+SetRxDropPolicy (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData,
+  IN  UINT8              *RxDropPolicy
+  )
+{
+  return RxDropPolicySet (&UndiPrivateData->NicInfo, *RxDropPolicy);
+}
+
+/** Sets packet buffer profile of the port.
+
+  @param[in]   UndiPrivateData       Pointer to driver private data structure
+  @param[in]   PacketBufferProfile   Packet buffer profile
+
+  @retval     EFI_SUCCESS            Operation successful
+  @retval     EFI_INVALID_PARAMETER  Unknown profile
+  @retval     !EFI_SUCCESS           Failed to store the profile
+**/
+EFI_STATUS
+SetPacketBufferProfile (
+  IN  UNDI_PRIVATE_DATA  *UndiPrivateData,
+  IN  UINT8              *PacketBufferProfile
+  )
+{
+  return E1000PacketBufferProfileSet (&UndiPrivateData->NicInfo, *PacketBufferProfile);
+}
+
 
 
@@ -40,7 +40,14 @@ HII_STATIC_INV_STRING_ENTRY  mHiiHwStaticInvStringMap[] = {
   ALL_LANG_ENTRY    (STRING_TOKEN (STR_DEVICE_NAME_TEXT),              FALSE, GetBrandStr,                NULL),
   ALL_LANG_ENTRY    (STRING_TOKEN (STR_DEVICE_ID_TEXT),                FALSE, GetDeviceIdStr,             NULL),
   ALL_LANG_ENTRY    (STRING_TOKEN (STR_CONTROLER_ID_TEXT),             FALSE, GetChipTypeStr,             NULL),
+};
+
+UINTN mHiiHwStaticInvStringMapSize = sizeof (mHiiHwStaticInvStringMap) / sizeof (mHiiHwStaticInvStringMap[0]);
+
+// Strings that need NVM or I2C reads, generated on first Config Access use
+HII_STATIC_INV_STRING_ENTRY  mHiiHwDeferredInvStringMap[] = {
   ALL_LANG_ENTRY    (STRING_TOKEN (STR_ADAPTER_PBA_TEXT),              FALSE, GetPbaStr,                  NULL),
+  ALL_LANG_ENTRY    (STRING_TOKEN (STR_SFP_MODULE_TEXT),               FALSE, GetSfpModuleStr,            NULL),
 };
 
-UINTN mHiiHwStaticInvStringMapSize = sizeof (mHiiHwStaticInvStringMap) / sizeof (mHiiHwStaticInvStringMap[0]);
\ No newline at end of file
+UINTN mHiiHwDeferredInvStringMapSize = sizeof (mHiiHwDeferredInvStringMap) / sizeof (mHiiHwDeferredInvStringMap[0]);
\ No newline at end of file
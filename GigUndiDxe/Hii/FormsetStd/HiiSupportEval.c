@@ -65,6 +65,23 @@ IsAltMacAddrSupported (
   return EFI_SUCCESS;
 }
 
+/** Checks if packet buffer profile attribute is supported.
+
+  @param[in]   UndiPrivateData  Pointer to driver private data structure
+  @param[out]  Supported        BOOLEAN support information
+
+  @retval    EFI_SUCCESS        Operation successful
+**/
+EFI_STATUS
+IsPacketBufferProfileSupported (
+  IN   UNDI_PRIVATE_DATA  *UndiPrivateData,
+  OUT  BOOLEAN            *Supported
+  )
+{
+  *Supported = E1000PacketBufferProfileSupported (&UndiPrivateData->NicInfo);
+  return EFI_SUCCESS;
+}
+
 
 
 
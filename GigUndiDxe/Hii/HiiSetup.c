@@ -52,6 +52,10 @@ extern HII_STATIC_INV_STRING_ENTRY     mHiiHwStaticInvStringMap[];
 
 extern UINTN                           mHiiHwStaticInvStringMapSize;
 
+extern HII_STATIC_INV_STRING_ENTRY     mHiiHwDeferredInvStringMap[];
+
+extern UINTN                           mHiiHwDeferredInvStringMapSize;
+
 /** Gets the next language code from native RFC 4646 language code array.
 
   @param[in]      Langs      Pointer to the string containing language array
@@ -96,6 +100,8 @@ HiiGetNextLanguage (
 /** Processes static inventory strings map for specific language OR language agnostic entries.
 
   @param[in]   UndiPrivateData  Pointer to driver private data structure
+  @param[in]   InvStringMap     Static inventory strings map to be processed
+  @param[in]   InvStringMapSize Number of entries in InvStringMap
   @param[in]   Language         Language for which map language specific entries should be processed,
                                 or NULL when language agnostic entries should be processed
 
@@ -108,8 +114,10 @@ HiiGetNextLanguage (
 **/
 EFI_STATUS
 HiiSetupStaticInventory (
-  IN        UNDI_PRIVATE_DATA  *UndiPrivateData,
-  IN CONST  CHAR8              *Language
+  IN        UNDI_PRIVATE_DATA            *UndiPrivateData,
+  IN        HII_STATIC_INV_STRING_ENTRY  *InvStringMap,
+  IN        UINTN                        InvStringMapSize,
+  IN CONST  CHAR8                        *Language
   )
 {
   EFI_STATUS                   Status;
@@ -123,8 +131,8 @@ HiiSetupStaticInventory (
 
   ASSERT (UndiPrivateData != NULL);
 
-  for (EntryIdx = 0; EntryIdx < mHiiHwStaticInvStringMapSize; EntryIdx++) {
-    InvStringEntry = &mHiiHwStaticInvStringMap[EntryIdx];
+  for (EntryIdx = 0; EntryIdx < InvStringMapSize; EntryIdx++) {
+    InvStringEntry = &InvStringMap[EntryIdx];
 
     if (((Language == NULL) && (InvStringEntry->GetStringType == LANG)) ||
         ((Language == NULL) && (InvStringEntry->GetStringType == LANG_FOR_STRING_ID)) ||
@@ -247,8 +255,120 @@ AddVarStoreConfig (
   return EFI_SUCCESS;
 }
 
+/** Generates the deferred static inventory strings (the ones that need NVM or I2C reads) on
+  demand. Called before every Config Access protocol operation: on first call evaluates HW
+  dependent support flags and sets language agnostic strings, then sets language specific strings
+  for current platform language and x-UEFI languages if they were not set yet. When platform
+  language can't be determined all languages are processed.
+
+  @param[in,out]   UndiPrivateData  Pointer to driver private data structure
+
+  @retval    EFI_SUCCESS            Inventory strings for current language are set
+  @retval    EFI_OUT_OF_RESOURCES   Failed to get supported languages
+  @retval    !EFI_SUCCESS           Failure of one of the other underlying functions
+**/
+EFI_STATUS
+HiiPrepareInventory (
+  IN OUT  UNDI_PRIVATE_DATA  *UndiPrivateData
+  )
+{
+  EFI_STATUS  Status;
+  HII_INFO    *HiiInfo;
+  CHAR8       SubLang[HII_MAX_STR_LEN];
+  UINTN       LanguagesSize;
+  UINTN       LanguagesIdx   = 0;
+  UINTN       LangBit        = 0;
+  UINTN       LangsProcessed = 0;
+  CHAR8       *PlatformLang  = NULL;
+  CHAR8       *BestLang      = NULL;
+
+  ASSERT (UndiPrivateData != NULL);
+
+  HiiInfo = &UndiPrivateData->HiiInfo;
+
+  if ((HiiInfo->InvLanguages != NULL) &&
+      (HiiInfo->InvLangDone == HiiInfo->InvLangAll))
+  {
+    return EFI_SUCCESS;
+  }
+
+  if (HiiInfo->InvLanguages == NULL) {
+    Status = SetHwDependentAdapterSupportFlags (UndiPrivateData);
+    IF_RETURN (EFI_ERROR (Status), Status);
+
+    HiiInfo->InvLanguages = HiiGetSupportedLanguages (HiiInfo->HiiPkgListHandle);
+    IF_NULL_RETURN (HiiInfo->InvLanguages, EFI_OUT_OF_RESOURCES);
+
+    DEBUGPRINT (HII, ("Package list languages - %a\n", HiiInfo->InvLanguages));
+  }
+
+  LanguagesSize = AsciiStrnLenS (HiiInfo->InvLanguages, HII_MAX_STR_LEN) + 1;
+
+  if (HiiInfo->InvLangAll == 0) {
+    while (HiiGetNextLanguage (HiiInfo->InvLanguages, &LanguagesIdx, LanguagesSize, SubLang) &&
+           (LangBit < 64))
+    {
+      HiiInfo->InvLangAll |= LShiftU64 (1, LangBit++);
+    }
+    LanguagesIdx = 0;
+    LangBit      = 0;
+  }
+
+  // Setup language agnostic inventory
+  if (!HiiInfo->InvAgnosticDone) {
+    Status = HiiSetupStaticInventory (
+               UndiPrivateData,
+               mHiiHwDeferredInvStringMap,
+               mHiiHwDeferredInvStringMapSize,
+               NULL
+               );
+    IF_RETURN (EFI_ERROR (Status), Status);
+    HiiInfo->InvAgnosticDone = TRUE;
+  }
+
+  GetEfiGlobalVariable2 (L"PlatformLang", (VOID **) &PlatformLang, NULL);
+  if (PlatformLang != NULL) {
+    BestLang = GetBestLanguage (HiiInfo->InvLanguages, FALSE, PlatformLang, NULL);
+  }
+
+  // Setup language specific inventory
+  Status = EFI_SUCCESS;
+  while (HiiGetNextLanguage (HiiInfo->InvLanguages, &LanguagesIdx, LanguagesSize, SubLang) &&
+         (LangBit < 64))
+  {
+    if (((HiiInfo->InvLangDone & LShiftU64 (1, LangBit)) == 0) &&
+        ((BestLang == NULL) ||
+         IS_UEFI_CONFIG_LANG (SubLang) ||
+         (AsciiStrCmp (SubLang, BestLang) == 0)))
+    {
+      Status = HiiSetupStaticInventory (
+                 UndiPrivateData,
+                 mHiiHwDeferredInvStringMap,
+                 mHiiHwDeferredInvStringMapSize,
+                 SubLang
+                 );
+      IF_GOTO (EFI_ERROR (Status), ExitFreeRes);
+      HiiInfo->InvLangDone |= LShiftU64 (1, LangBit);
+      LangsProcessed++;
+    }
+    LangBit++;
+  }
+
+  DEBUGPRINT (HII, ("Inventory set for %d languages, best lang %a\n", LangsProcessed, BestLang));
+
+ExitFreeRes:
+  if (PlatformLang != NULL) {
+    FreePool (PlatformLang);
+  }
+  if (BestLang != NULL) {
+    FreePool (BestLang);
+  }
+  return Status;
+}
+
 /** Main function that sets up inventory packages. Adds configuration for supported varstores &
-  adds required packages, runs static inventory map processing.
+  adds required packages, runs static inventory map processing. Processing of the deferred map
+  is left to first HII access.
 
   @param[in,out]   UndiPrivateData  Pointer to driver private data structure
 
@@ -277,14 +397,12 @@ HiiSetupInventoryPackages (
 
   HiiInfo = &UndiPrivateData->HiiInfo;
 
-  Status = SetHwDependentAdapterSupportFlags (UndiPrivateData);
-  IF_RETURN (EFI_ERROR (Status), Status);
-
   HiiInfo->HiiCfgAccessInfo.VarStoreConfigs = AllocateZeroPool (HII_VARSTORES_MAX * sizeof (HII_VARSTORE_MAP_CFG));
   IF_NULL_RETURN (HiiInfo->HiiCfgAccessInfo.VarStoreConfigs, EFI_OUT_OF_RESOURCES);
 
   HiiInfo->HiiCfgAccessInfo.OnActionChanging      = HiiOnActionChanging;
   HiiInfo->HiiCfgAccessInfo.OnActionChanged       = HiiOnActionChanged;
+  HiiInfo->HiiCfgAccessInfo.PrepareAccess         = HiiPrepareInventory;
   HiiInfo->HiiCfgAccessInfo.CallBackDriverContext = UndiPrivateData;
 
   Status = AddVarStoreConfig (&HiiInfo->HiiCfgAccessInfo, &mHiiStandardMapCfg, UndiPrivateData, TRUE);
@@ -304,10 +422,15 @@ HiiSetupInventoryPackages (
   Languages = HiiGetSupportedLanguages (HiiInfo->HiiPkgListHandle);
   IF_GOTO (Languages == NULL, ExitFreeRes);
 
-  DEBUGPRINT (HII, ("Package list languages - %a\n"));
-
-  // Setup language agnostic inventory
-  Status = HiiSetupStaticInventory (UndiPrivateData, NULL);
+  // Formset title, help and MAC address are read straight from the HII database by the
+  // Device Manager, so the cheap strings are set here. The deferred map is processed on
+  // first HII access, see HiiPrepareInventory ()
+  Status = HiiSetupStaticInventory (
+             UndiPrivateData,
+             mHiiHwStaticInvStringMap,
+             mHiiHwStaticInvStringMapSize,
+             NULL
+             );
   IF_GOTO (EFI_ERROR (Status), ExitFreeRes);
 
   // assume size of returned languages will never be longer than HII_MAX_STR_LEN
@@ -315,7 +438,12 @@ HiiSetupInventoryPackages (
 
   // Setup language specific inventory
   while (HiiGetNextLanguage (Languages, &LanguagesIdx, LanguagesSize, SubLang)) {
-    Status = HiiSetupStaticInventory (UndiPrivateData, SubLang);
+    Status = HiiSetupStaticInventory (
+               UndiPrivateData,
+               mHiiHwStaticInvStringMap,
+               mHiiHwStaticInvStringMapSize,
+               SubLang
+               );
     IF_GOTO (EFI_ERROR (Status), ExitFreeRes);
   }
 
@@ -410,9 +538,14 @@ HiiUnload (
     HiiInfo->HiiPkgListHandle = NULL;
   }
 
+  if (HiiInfo->InvLanguages != NULL) {
+    FreePool (HiiInfo->InvLanguages);
+    HiiInfo->InvLanguages = NULL;
+  }
 
   if (HiiInfo->HiiInstallHandle != NULL) {
     if (HiiInfo->HiiCfgAccessInfo.VarStoreConfigs != NULL) {
+      FreeVarStoreSnapshots (&HiiInfo->HiiCfgAccessInfo);
       FreePool (HiiInfo->HiiCfgAccessInfo.VarStoreConfigs);
       HiiInfo->HiiCfgAccessInfo.VarStoreConfigs = NULL;
     }
@@ -48,6 +48,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define MAC_ADDRESS_SIZE_IN_BYTES 6
 
+/* Number of handles remembered as definitely not supported (power of 2) */
+#define UNSUPPORTED_CACHE_SIZE  256
+#define UNSUPPORTED_CACHE_SLOT(Handle) \
+  ((((UINTN) (Handle)) >> 3) & (UNSUPPORTED_CACHE_SIZE - 1))
+
 /* Global Variables */
 VOID               *mE1000PxeMemPtr = NULL;
 PXE_SW_UNDI        *mE1000Pxe31 = NULL;  // 3.1 entry
@@ -61,6 +66,13 @@ EFI_SYSTEM_TABLE   *gSystemTable;
 BOOLEAN            mExitBootServicesTriggered = FALSE;
 UINT8              *gUndiDxeHiiStringsPkgPtr = GigUndiDxeStrings;
 
+/* Handles Supported() already rejected for good, and what it saved */
+EFI_HANDLE         mUnsupportedHandles[UNSUPPORTED_CACHE_SIZE];
+EFI_EVENT          mEventNotifyPciIo;
+VOID               *mPciIoRegistration = NULL;
+UINT32             mSupportedCalls     = 0;
+UINT32             mSupportedCacheHits = 0;
+
 
 EFI_GUID gEfiNiiPointerGuid = EFI_NII_POINTER_PROTOCOL_GUID;
 
@@ -232,22 +244,106 @@ GigUndiNotifyExitBs (
   )
 {
   UNDI_PRIVATE_DATA   *Device;
+  BOOLEAN             Busy;
+  UINTN               Elapsed;
 
   // Set the indicator to block DMA access in UNDI functions.
   // This will also prevent functions below from calling Memory Allocation
   // Services which should not be done at this stage.
   mExitBootServicesTriggered = TRUE;
+  Busy                       = FALSE;
 
+  // Ask all ports to stop DMA first, so they drain in parallel and the
+  // handoff waits for the slowest port instead of the sum of all of them
   FOREACH_ACTIVE_CONTROLLER (Device) {
-    if (Device->NicInfo.Hw.device_id != 0) {
-      if (Device->IsChildInitialized) {
-        E1000Shutdown (&Device->NicInfo);
-        E1000PciFlush (&Device->NicInfo.Hw);
-        // Delay for 10ms to allow in progress DMA to complete
-        gBS->Stall (10000);
+    if ((Device->NicInfo.Hw.device_id != 0)
+      && Device->IsChildInitialized)
+    {
+      E1000QuiesceStart (&Device->NicInfo);
+    }
+  }
+
+  for (Elapsed = 0; Elapsed < QUIESCE_TIMEOUT_US; Elapsed += QUIESCE_POLL_US) {
+    Busy = FALSE;
+    FOREACH_ACTIVE_CONTROLLER (Device) {
+      if ((Device->NicInfo.Hw.device_id != 0)
+        && Device->IsChildInitialized
+        && !E1000QuiesceDone (&Device->NicInfo))
+      {
+        Busy = TRUE;
+        break;
       }
     }
+
+    if (!Busy) {
+      break;
+    }
+
+    gBS->Stall (QUIESCE_POLL_US);
   }
+
+  DEBUGPRINT (INIT, ("Ports quiesced after %d us%a\n", Elapsed, Busy ? ", timed out" : ""));
+  DEBUGPRINT (
+    INIT, ("Supported() called %d times, %d answered from cache\n",
+    mSupportedCalls, mSupportedCacheHits)
+  );
+}
+
+/** Drops handles that got a new or reinstalled PciIo from the unsupported cache
+
+   A cached verdict is only stale once PciIo changes on that handle, which
+   also covers a freed handle being reused for a new PCI function.
+
+   @retval   None
+**/
+STATIC
+VOID
+UnsupportedCacheFlushNew (
+  VOID
+  )
+{
+  EFI_STATUS Status;
+  EFI_HANDLE Handle;
+  UINTN      BufferSize;
+  UINTN      Slot;
+
+  if (mPciIoRegistration == NULL) {
+    return;
+  }
+
+  do {
+    BufferSize = sizeof (Handle);
+    Status = gBS->LocateHandle (
+                    ByRegisterNotify,
+                    NULL,
+                    mPciIoRegistration,
+                    &BufferSize,
+                    &Handle
+                  );
+    if (!EFI_ERROR (Status)) {
+      Slot = UNSUPPORTED_CACHE_SLOT (Handle);
+      if (mUnsupportedHandles[Slot] == Handle) {
+        mUnsupportedHandles[Slot] = NULL;
+      }
+    }
+  } while (!EFI_ERROR (Status));
+}
+
+/** PciIo install notification, invalidates cached Supported() verdicts
+
+   @param[in]   Event     Event whose notification function is being invoked.
+   @param[in]   Context   Pointer to the notification function's context (unused)
+
+   @retval   None
+**/
+VOID
+EFIAPI
+GigUndiNotifyPciIo (
+  EFI_EVENT Event,
+  VOID *    Context
+  )
+{
+  UnsupportedCacheFlushNew ();
 }
 
 /** Allocates new device path which consists of original and MAC address appended
@@ -562,6 +658,12 @@ GigUndiUnload (
       return Status;
     }
 
+    if (mEventNotifyPciIo != NULL) {
+      gBS->CloseEvent (mEventNotifyPciIo);
+      mEventNotifyPciIo  = NULL;
+      mPciIoRegistration = NULL;
+    }
+
     DEBUGPRINT (INIT, ("Uninstalling UEFI 1.10/2.10 Driver Diags and Component Name protocols.\n"));
     Status = gBS->UninstallMultipleProtocolInterfaces (
                     ImageHandle,
@@ -685,6 +787,19 @@ InitializeGigUNDIDriver (
     DEBUGPRINT (CRITICAL, ("CreateEvent returns %r\n", Status));
     return Status;
   }
+
+  // Without the notification Supported() simply runs uncached
+  mEventNotifyPciIo = EfiCreateProtocolNotifyEvent (
+                        &gEfiPciIoProtocolGuid,
+                        TPL_CALLBACK,
+                        GigUndiNotifyPciIo,
+                        NULL,
+                        &mPciIoRegistration
+                      );
+  if (mEventNotifyPciIo == NULL) {
+    mPciIoRegistration = NULL;
+  }
+
   Status = InitializePxeStruct ();
 
   return Status;
@@ -842,6 +957,10 @@ AnalyzeRemainingDevicePath (
    Class code of 2, Vendor ID of 0x8086, and DeviceId matching an Intel
    adapter can be supported.
 
+   Handles rejected because they carry no PciIo or hold a device this driver
+   does not support are remembered, so repeated connect passes answer them
+   without opening PciIo again.
+
    @param[in]   This                  Protocol instance pointer.
    @param[in]   Controller            Handle of device to test.
    @param[in]   RemainingDevicePath   Remaining part of device path.
@@ -863,6 +982,26 @@ GigUndiDriverSupported (
   EFI_PCI_IO_PROTOCOL *PciIo;
   PCI_TYPE00           Pci;
   UNDI_PRIVATE_DATA *UndiPrivateData;
+  EFI_TPL              OldTpl;
+  UINTN                Slot;
+
+  mSupportedCalls++;
+  Slot = UNSUPPORTED_CACHE_SLOT (Controller);
+
+  // Hold off the PciIo notification so a verdict cannot be cached after
+  // the handle it describes has already changed
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+
+  if (mUnsupportedHandles[Slot] == Controller) {
+
+    // Notifications may still be pending when called at TPL_CALLBACK
+    UnsupportedCacheFlushNew ();
+    if (mUnsupportedHandles[Slot] == Controller) {
+      mSupportedCacheHits++;
+      gBS->RestoreTPL (OldTpl);
+      return EFI_UNSUPPORTED;
+    }
+  }
 
   UndiPrivateData = GetControllerPrivateData (Controller);
 
@@ -877,11 +1016,20 @@ GigUndiDriverSupported (
                   );
 
     if (EFI_ERROR (Status)) {
+
+      // No PciIo at all, as opposed to PciIo owned by someone else
+      if ((Status == EFI_UNSUPPORTED)
+        && (mPciIoRegistration != NULL))
+      {
+        mUnsupportedHandles[Slot] = Controller;
+      }
+      gBS->RestoreTPL (OldTpl);
       return Status;
     }
   } else {
     PciIo = UndiPrivateData->NicInfo.PciIo;
     if (PciIo == NULL) {
+      gBS->RestoreTPL (OldTpl);
       return EFI_INVALID_PARAMETER;
     }
   }
@@ -898,6 +1046,9 @@ GigUndiDriverSupported (
   }
 
   if (!IsDeviceIdSupported (Pci.Hdr.VendorId, Pci.Hdr.DeviceId)) {
+    if (mPciIoRegistration != NULL) {
+      mUnsupportedHandles[Slot] = Controller;
+    }
     Status = EFI_UNSUPPORTED;
     goto ExitSupported;
   }
@@ -920,6 +1071,7 @@ ExitSupported:
          );
   }
 
+  gBS->RestoreTPL (OldTpl);
   return Status;
 }
 
@@ -1143,11 +1295,20 @@ InitUndiPrivateData (
   UNDI_PRIVATE_DATA   *PrivateData;
   EFI_STATUS          Status;
 
-  PrivateData = AllocateZeroPool (sizeof (UNDI_PRIVATE_DATA));
+  // Pages keep NicInfo, and with it the per packet fields, cache line aligned
+  PrivateData = AllocatePages (EFI_SIZE_TO_PAGES (sizeof (UNDI_PRIVATE_DATA)));
   if (PrivateData == NULL) {
     DEBUGPRINTWAIT (CRITICAL, ("Failed to allocate PrivateData!\n"));
     return EFI_OUT_OF_RESOURCES;
   }
+  ZeroMem (PrivateData, sizeof (UNDI_PRIVATE_DATA));
+
+  PrivateData->NicInfo.Cold = AllocateZeroPool (sizeof (DRIVER_DATA_COLD));
+  if (PrivateData->NicInfo.Cold == NULL) {
+    DEBUGPRINTWAIT (CRITICAL, ("Failed to allocate PrivateData!\n"));
+    FreePages (PrivateData, EFI_SIZE_TO_PAGES (sizeof (UNDI_PRIVATE_DATA)));
+    return EFI_OUT_OF_RESOURCES;
+  }
 
   PrivateData->Signature              = UNDI_DEV_SIGNATURE;
   PrivateData->DeviceHandle           = NULL;
@@ -1166,7 +1327,8 @@ InitUndiPrivateData (
     *UndiPrivateData = PrivateData;
   } else {
     *UndiPrivateData = NULL;
-    FreePool (PrivateData);
+    FreePool (PrivateData->NicInfo.Cold);
+    FreePages (PrivateData, EFI_SIZE_TO_PAGES (sizeof (UNDI_PRIVATE_DATA)));
   }
 
   return Status;
@@ -1293,29 +1455,10 @@ InitController (
   if (Status == EFI_ACCESS_DENIED) {
     UndiPrivateData->NicInfo.UndiEnabled = FALSE;
   } else {
-    // Initialize Tx & Rx queues
-    Status = TransmitInitialize (
-               &UndiPrivateData->NicInfo,
-               DEFAULT_TX_DESCRIPTORS
-               );
-
-    if (EFI_ERROR (Status)) {
-      DEBUGPRINT (CRITICAL, ("Failed to initialize Tx queue: %r\n", Status));
-      return Status;
-    }
-
-    Status = ReceiveInitialize (
-               &UndiPrivateData->NicInfo,
-               DEFAULT_RX_DESCRIPTORS,
-               RX_BUFFER_SIZE
-               );
-
-    if (EFI_ERROR (Status)) {
-      DEBUGPRINT (CRITICAL, ("Failed to initialize Rx queue: %r\n", Status));
-      TransmitCleanup (&UndiPrivateData->NicInfo);
-      return Status;
-    }
+    RxDropPolicyLoad (&UndiPrivateData->NicInfo);
 
+    // Tx & Rx queues are allocated by the UNDI Initialize command, ports that
+    // never carry traffic hold no DMA memory
     UndiPrivateData->NicInfo.UndiEnabled = TRUE;
   }
 
@@ -1437,6 +1580,18 @@ InitChildProtocols (
     return Status;
   }
 
+  // Not fatal, Driver Health then reports the adapter as healthy
+  Status = HealthMonitorStart (UndiPrivateData);
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("HealthMonitorStart returned %r\n", Status));
+  }
+
+  // Not fatal, VLANs added later are then picked up by the next Initialize
+  Status = RxVlanFilterWatchStart (&UndiPrivateData->NicInfo);
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("RxVlanFilterWatchStart returned %r\n", Status));
+  }
+
   // Initialize HII Protocols
   Status = HiiInit (UndiPrivateData);
   if (EFI_ERROR (Status)) {
@@ -1689,7 +1844,8 @@ UndiError:
   );
   if (UndiPrivateData != NULL) {
     RemoveControllerPrivateData (UndiPrivateData);
-    gBS->FreePool ((VOID **) UndiPrivateData);
+    FreePool (UndiPrivateData->NicInfo.Cold);
+    FreePages (UndiPrivateData, EFI_SIZE_TO_PAGES (sizeof (UNDI_PRIVATE_DATA)));
   }
   return Status;
 }
@@ -1736,6 +1892,8 @@ StopChild (
     return Status;
   }
 
+  HealthMonitorStop (UndiPrivateData);
+  RxVlanFilterWatchStop (&UndiPrivateData->NicInfo);
 
   Status = UninstallAdapterInformationProtocol (UndiPrivateData);
   if ((EFI_ERROR (Status)) && (Status != EFI_UNSUPPORTED)) {
@@ -1860,16 +2018,9 @@ StopController (
     DEBUGPRINT (CRITICAL, ("FreePool(UndiPrivateData->Undi32DevPath) returns %r\n", Status));
   }
 
-  // Free DMA resources: Tx & Rx descriptors, Rx buffers
-  Status = TransmitCleanup (&UndiPrivateData->NicInfo);
-  if (EFI_ERROR (Status)) {
-    DEBUGPRINT (CRITICAL, ("TransmitCleanup returned %r\n", Status));
-    return Status;
-  }
-
-  Status = ReceiveCleanup (&UndiPrivateData->NicInfo);
+  // Free DMA resources: Tx & Rx descriptors, Rx buffers, including lingering ones
+  Status = E1000RingsRelease (&UndiPrivateData->NicInfo);
   if (EFI_ERROR (Status)) {
-    DEBUGPRINT (CRITICAL, ("ReceiveCleanup returned %r\n", Status));
     return Status;
   }
 
@@ -1899,11 +2050,8 @@ StopController (
     return Status;
   }
 
-  Status = gBS->FreePool (UndiPrivateData);
-  if (EFI_ERROR (Status)) {
-    DEBUGPRINT (CRITICAL, ("FreePool(UndiPrivateData) returns %r\n", Status));
-    DEBUGWAIT (CRITICAL);
-  }
+  FreePool (UndiPrivateData->NicInfo.Cold);
+  FreePages (UndiPrivateData, EFI_SIZE_TO_PAGES (sizeof (UNDI_PRIVATE_DATA)));
   return EFI_SUCCESS;
 }
 
@@ -199,7 +199,7 @@ ReceiveInitializeDescriptors (
   ASSERT (RxRing != NULL);
 
   // Are descriptors & buffers allocated and mapped?
-  // EFI_SUCCESS from UndiDmaAllocateCommonBuffer also ensures that
+  // EFI_SUCCESS from UndiDmaRegionAllocate also ensures that
   // memory area sizes for descriptors and Rx buffers are correct.
   ASSERT (RxRing->Descriptors.PhysicalAddress != 0);
   ASSERT (RxRing->Buffers.PhysicalAddress != 0);
@@ -282,10 +282,12 @@ ReceiveInitialize (
   RxRing->BufferSize   = BufferSize;
 
   // Allocate Rx descriptors
-  RxRing->Descriptors.Size = ALIGN (RxRing->BufferCount * sizeof (RECEIVE_DESCRIPTOR), 4096);
+  RxRing->Descriptors.Size = RxRing->BufferCount * sizeof (RECEIVE_DESCRIPTOR);
 
-  Status = UndiDmaAllocateCommonBuffer (
+  Status = UndiDmaRegionAllocate (
              PCI_IO_FROM_ADAPTER (AdapterInfo),
+             &AdapterInfo->DmaRegion,
+             UNDI_DMA_RING_ALIGN,
              &RxRing->Descriptors
              );
 
@@ -303,10 +305,12 @@ ReceiveInitialize (
     );
 
   // Allocate Rx buffers
-  RxRing->Buffers.Size = ALIGN (RxRing->BufferCount * RxRing->BufferSize, 4096);
+  RxRing->Buffers.Size = RxRing->BufferCount * RxRing->BufferSize;
 
-  Status = UndiDmaAllocateCommonBuffer (
+  Status = UndiDmaRegionAllocate (
              PCI_IO_FROM_ADAPTER (AdapterInfo),
+             &AdapterInfo->DmaRegion,
+             UNDI_DMA_CACHE_LINE,
              &RxRing->Buffers
              );
 
@@ -364,13 +368,13 @@ ReceiveInitialize (
   return EFI_SUCCESS;
 
 ExitFreeBufs:
-  UndiDmaFreeCommonBuffer (
+  UndiDmaRegionFree (
     PCI_IO_FROM_ADAPTER (AdapterInfo),
     &RxRing->Buffers
     );
 
 ExitFreeDesc:
-  UndiDmaFreeCommonBuffer (
+  UndiDmaRegionFree (
     PCI_IO_FROM_ADAPTER (AdapterInfo),
     &RxRing->Descriptors
     );
@@ -434,7 +438,7 @@ ReceiveCleanup (
   }
 
   // Free Rx descriptor DMA region
-  Status = UndiDmaFreeCommonBuffer (
+  Status = UndiDmaRegionFree (
              PCI_IO_FROM_ADAPTER (AdapterInfo),
              &RxRing->Descriptors
              );
@@ -446,7 +450,7 @@ ReceiveCleanup (
   }
 
   // Free Rx buffers DMA region
-  Status = UndiDmaFreeCommonBuffer (
+  Status = UndiDmaRegionFree (
              PCI_IO_FROM_ADAPTER (AdapterInfo),
              &RxRing->Buffers
              );
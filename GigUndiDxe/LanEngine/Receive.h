@@ -55,6 +55,25 @@ typedef struct _RECEIVE_RING {
 
 #define MIN_ETHERNET_PACKET_LENGTH  60
 
+/* Small Rx queue for control traffic, drained before the main ring */
+#define RX_PRIORITY_QUEUE          1
+#define RX_PRIORITY_DESCRIPTORS    16
+
+/* ETQF filters steering control traffic to the priority queue, the ones
+   below are used by the receive drop policy */
+#define RX_PRIORITY_ETQF_FIRST     4
+#define RX_PRIORITY_ETQF_COUNT     3
+
+typedef struct {
+  BOOLEAN           IsInitialized;
+  BOOLEAN           IsRunning;
+  UINT16            NextToUse;
+  UNDI_DMA_MAPPING  Descriptors;
+  UNDI_DMA_MAPPING  Buffers;
+  UINT64            FramesReceived; // frames taken from the priority queue
+  UINT64            FramesDropped;  // frames lost because the queue was full
+} RX_PRIORITY_RING;
+
 /**
   Initialize Rx ring structure of LAN engine.
   This function will allocate and initialize all the necessary resources.
@@ -207,4 +226,88 @@ ReceiveGetPacket (
   OUT     UINT16        *PacketLength
   );
 
+/** Checks whether the MAC can steer control traffic to a priority Rx queue.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @retval   TRUE    Priority queue supported
+   @retval   FALSE   Priority queue not supported
+**/
+BOOLEAN
+RxPriorityRingSupported (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Allocates the descriptors and buffers of the priority Rx queue.
+
+   Must be called before ReceiveInitialize, which configures the queue along
+   with the main ring. Failing to allocate leaves the queue disabled.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @retval   EFI_SUCCESS            Priority queue allocated
+   @retval   EFI_UNSUPPORTED        MAC has no priority queue
+   @retval   EFI_OUT_OF_RESOURCES   Failed to allocate DMA memory
+**/
+EFI_STATUS
+RxPriorityRingInitialize (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Frees the resources of the priority Rx queue.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Priority queue resources freed
+**/
+VOID
+RxPriorityRingCleanup (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Takes a packet from the priority Rx queue.
+
+   @param[in]      AdapterInfo    Pointer to the NIC data structure
+   @param[out]     Buffer         Buffer to hold received packet
+   @param[in,out]  BufferSize     On input, length of provided buffer.
+                                  On output, number of bytes transferred.
+   @param[out]     PacketLength   On output, full length of received packet
+
+   @retval   EFI_SUCCESS        Packet received
+   @retval   EFI_NOT_READY      No packet in the priority queue
+   @retval   EFI_DEVICE_ERROR   Error reported via Rx descriptor
+**/
+EFI_STATUS
+RxPriorityRingGetPacket (
+  IN     DRIVER_DATA *AdapterInfo,
+  OUT    UINT8       *Buffer,
+  IN OUT UINT16      *BufferSize,
+  OUT    UINT16      *PacketLength
+  );
+
+/** Checks whether the priority Rx queue holds a packet.
+
+   @param[in]    AdapterInfo    Pointer to the NIC data structure
+   @param[out]   PacketLength   On output, length of received packet
+
+   @retval   EFI_SUCCESS     Packet ready
+   @retval   EFI_NOT_READY   No packet in the priority queue
+**/
+EFI_STATUS
+RxPriorityRingIsPacketReady (
+  IN  DRIVER_DATA *AdapterInfo,
+  OUT UINT16      *PacketLength
+  );
+
+/** Accumulates the drop counter of the priority Rx queue.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   AdapterInfo->PriorityRxRing counters updated
+**/
+VOID
+RxPriorityRingUpdateCounters (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
 #endif /* RECEIVE_H_ */
@@ -28,6 +28,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #include "CommonDriver.h"
 
+/* Rx descriptor as snapshotted from the ring, write-back fields in Qword[1] */
+typedef union {
+  RECEIVE_DESCRIPTOR  Desc;
+  UINT64              Qword[2];
+} RECEIVE_DESCRIPTOR_SNAPSHOT;
+
 /**
   Write physical address of the Rx buffer to a specific field within
   Rx descriptor.
@@ -42,12 +48,19 @@ ReceiveAttachBufferToDescriptor (
   IN  EFI_PHYSICAL_ADDRESS  RxBuffer
   )
 {
+  RECEIVE_DESCRIPTOR  Desc;
+
   ASSERT (RxDesc != NULL);
   ASSERT (RxBuffer != 0);
 
-  ZeroMem (RxDesc, sizeof (*RxDesc));
-  RxDesc->buffer_addr = (UINT64) RxBuffer;
-  RxDesc->status = E1000_RXD_STAT_IXSM;
+  Desc.buffer_addr = (UINT64) RxBuffer;
+  Desc.length      = 0;
+  Desc.csum        = 0;
+  Desc.status      = E1000_RXD_STAT_IXSM;
+  Desc.errors      = 0;
+  Desc.special     = 0;
+
+  UndiDmaDescriptorWrite (RxDesc, &Desc);
 }
 
 /**
@@ -74,21 +87,25 @@ ReceiveIsDescriptorDone (
   OUT UINT8               *PacketType     OPTIONAL
   )
 {
+  RECEIVE_DESCRIPTOR_SNAPSHOT Snapshot;
+
   ASSERT (RxDesc != NULL);
 
-  if (!BIT_TEST (RxDesc->status, E1000_RXD_STAT_EOP | E1000_RXD_STAT_DD)) {
+  Snapshot.Qword[1] = UndiDmaDescriptorReadWriteBack (RxDesc);
+
+  if (!BIT_TEST (Snapshot.Desc.status, E1000_RXD_STAT_EOP | E1000_RXD_STAT_DD)) {
     return FALSE;
   }
 
   if (PacketLength != NULL) {
-    *PacketLength = RxDesc->length;
+    *PacketLength = Snapshot.Desc.length;
   }
   if (HeaderLength != NULL) {
     // No header length in legacy descriptors.
     *HeaderLength = 0;
   }
   if (RxError != NULL) {
-    *RxError = RxDesc->errors;
+    *RxError = Snapshot.Desc.errors;
   }
   if (PacketType != NULL) {
     // No packet type in legacy descriptors.
@@ -116,6 +133,447 @@ ReceiveUpdateTail (
   E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDT (0), DescId);
 }
 
+/* L2 control protocols steered to the priority queue */
+STATIC UINT16 mRxPriorityEtherTypes[RX_PRIORITY_ETQF_COUNT] = {
+  0x0806, // ARP
+  0x8035, // RARP
+  0x888E  // EAPOL
+};
+
+STATIC_ASSERT (
+  RX_PRIORITY_QUEUE < 2,
+  "Priority queue must exist on i211, which has two Rx queues"
+  );
+
+/** Get virtual address of specific descriptor of the priority Rx queue
+
+   @param[in]   ring  Priority ring pointer
+   @param[in]   i     Desired descriptor index
+
+   @return    Pointer to Rx descriptor indexed by i
+ */
+#define PRIORITY_DESCRIPTOR_VA(ring, i) \
+  (RECEIVE_DESCRIPTOR*) ((ring)->Descriptors.UnmappedAddress + ((i) * sizeof (RECEIVE_DESCRIPTOR)))
+
+/** Get virtual address of specific buffer of the priority Rx queue
+
+   @param[in]   ring  Priority ring pointer
+   @param[in]   i     Desired buffer index
+
+   @return    Pointer to Rx buffer indexed by i
+ */
+#define PRIORITY_BUFFER_VA(ring, i) \
+  (UINT8*) ((ring)->Buffers.UnmappedAddress + ((i) * RX_BUFFER_SIZE))
+
+/** Get physical address of specific buffer of the priority Rx queue
+
+   @param[in]   ring  Priority ring pointer
+   @param[in]   i     Desired buffer index
+
+   @return    Physical address of Rx buffer indexed by i
+ */
+#define PRIORITY_BUFFER_PA(ring, i) \
+  (EFI_PHYSICAL_ADDRESS) ((ring)->Buffers.PhysicalAddress + ((i) * RX_BUFFER_SIZE))
+
+/** Checks whether the MAC can steer control traffic to a priority Rx queue.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @retval   TRUE    Priority queue supported
+   @retval   FALSE   Priority queue not supported
+**/
+BOOLEAN
+RxPriorityRingSupported (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  // 82575 has no EtherType queue filters. i211 has two Rx queues only, the
+  // priority queue is the second one.
+  switch (AdapterInfo->Hw.mac.type) {
+#ifndef NO_82575_SUPPORT
+#ifndef NO_82576_SUPPORT
+  case e1000_82576:
+#endif /* !NO_82576_SUPPORT */
+#ifndef NO_82580_SUPPORT
+  case e1000_82580:
+#endif /* !NO_82580_SUPPORT */
+  case e1000_i350:
+  case e1000_i354:
+#ifndef NO_I210_SUPPORT
+  case e1000_i210:
+  case e1000_i211:
+#endif /* !NO_I210_SUPPORT */
+    return TRUE;
+#endif /* !NO_82575_SUPPORT */
+  default:
+    return FALSE;
+  }
+}
+
+/** Allocates the descriptors and buffers of the priority Rx queue.
+
+   Must be called before ReceiveInitialize, which configures the queue along
+   with the main ring. Failing to allocate leaves the queue disabled.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @retval   EFI_SUCCESS            Priority queue allocated
+   @retval   EFI_UNSUPPORTED        MAC has no priority queue
+   @retval   EFI_OUT_OF_RESOURCES   Failed to allocate DMA memory
+**/
+EFI_STATUS
+RxPriorityRingInitialize (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_PRIORITY_RING  *Ring;
+  EFI_STATUS        Status;
+
+  Ring = &AdapterInfo->PriorityRxRing;
+
+  if (!RxPriorityRingSupported (AdapterInfo)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  ZeroMem (Ring, sizeof (RX_PRIORITY_RING));
+
+  Ring->Descriptors.Size = RX_PRIORITY_DESCRIPTORS * sizeof (RECEIVE_DESCRIPTOR);
+  Status = UndiDmaRegionAllocate (
+             PCI_IO_FROM_ADAPTER (AdapterInfo),
+             &AdapterInfo->DmaRegion,
+             UNDI_DMA_RING_ALIGN,
+             &Ring->Descriptors
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("Failed to allocate priority Rx descriptors: %r\n", Status));
+    ZeroMem (Ring, sizeof (RX_PRIORITY_RING));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Ring->Buffers.Size = RX_PRIORITY_DESCRIPTORS * RX_BUFFER_SIZE;
+  Status = UndiDmaRegionAllocate (
+             PCI_IO_FROM_ADAPTER (AdapterInfo),
+             &AdapterInfo->DmaRegion,
+             UNDI_DMA_CACHE_LINE,
+             &Ring->Buffers
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("Failed to allocate priority Rx buffers: %r\n", Status));
+    UndiDmaRegionFree (PCI_IO_FROM_ADAPTER (AdapterInfo), &Ring->Descriptors);
+    ZeroMem (Ring, sizeof (RX_PRIORITY_RING));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Ring->IsInitialized = TRUE;
+  return EFI_SUCCESS;
+}
+
+/** Frees the resources of the priority Rx queue.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Priority queue resources freed
+**/
+VOID
+RxPriorityRingCleanup (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_PRIORITY_RING  *Ring;
+
+  Ring = &AdapterInfo->PriorityRxRing;
+
+  if (!Ring->IsInitialized) {
+    return;
+  }
+
+  ASSERT (!Ring->IsRunning);
+
+  UndiDmaRegionFree (PCI_IO_FROM_ADAPTER (AdapterInfo), &Ring->Buffers);
+  UndiDmaRegionFree (PCI_IO_FROM_ADAPTER (AdapterInfo), &Ring->Descriptors);
+  ZeroMem (Ring, sizeof (RX_PRIORITY_RING));
+}
+
+/** Attaches all buffers of the priority Rx queue and hands the ring to the NIC.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Priority queue configured
+**/
+VOID
+RxPriorityRingConfigure (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_PRIORITY_RING  *Ring;
+  UINT64            MemAddr;
+  UINT32            *MemPtr;
+  UINT16            i;
+
+  Ring = &AdapterInfo->PriorityRxRing;
+
+  if (!Ring->IsInitialized) {
+    return;
+  }
+
+  for (i = 0; i < RX_PRIORITY_DESCRIPTORS; i++) {
+    ReceiveAttachBufferToDescriptor (
+      PRIORITY_DESCRIPTOR_VA (Ring, i),
+      PRIORITY_BUFFER_PA (Ring, i)
+      );
+  }
+
+  MemAddr = Ring->Descriptors.PhysicalAddress;
+  MemPtr  = (UINT32 *) &MemAddr;
+
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDBAL (RX_PRIORITY_QUEUE), MemPtr[0]);
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDBAH (RX_PRIORITY_QUEUE), MemPtr[1]);
+  E1000_WRITE_REG (
+    &AdapterInfo->Hw,
+    E1000_RDLEN (RX_PRIORITY_QUEUE),
+    sizeof (RECEIVE_DESCRIPTOR) * RX_PRIORITY_DESCRIPTORS
+    );
+
+  // A full priority queue drops instead of stalling the main ring
+  E1000_WRITE_REG (
+    &AdapterInfo->Hw,
+    E1000_SRRCTL (RX_PRIORITY_QUEUE),
+    E1000_SRRCTL_DESCTYPE_LEGACY | E1000_SRRCTL_DROP_EN
+    );
+
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDH (RX_PRIORITY_QUEUE), 0);
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDT (RX_PRIORITY_QUEUE), 0);
+
+  Ring->NextToUse = 0;
+}
+
+/** Enables the priority Rx queue and steers control traffic to it.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Priority queue enabled
+**/
+VOID
+RxPriorityRingEnable (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_PRIORITY_RING  *Ring;
+  UINT32            TempReg;
+  UINTN             i;
+
+  Ring = &AdapterInfo->PriorityRxRing;
+
+  if (!Ring->IsInitialized
+    || Ring->IsRunning)
+  {
+    return;
+  }
+
+  E1000SetRegBits (AdapterInfo, E1000_RXDCTL (RX_PRIORITY_QUEUE), E1000_RXDCTL_QUEUE_ENABLE);
+
+  i = 0;
+  do {
+    gBS->Stall (1);
+    TempReg = E1000_READ_REG (&AdapterInfo->Hw, E1000_RXDCTL (RX_PRIORITY_QUEUE));
+
+    i++;
+    if (i >= MAX_QUEUE_ENABLE_TIME) {
+      break;
+    }
+  } while (!BIT_TEST (TempReg, E1000_RXDCTL_QUEUE_ENABLE));
+
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDT (RX_PRIORITY_QUEUE), RX_PRIORITY_DESCRIPTORS - 1);
+
+  // Drop count restarts with the queue
+  E1000_READ_REG (&AdapterInfo->Hw, E1000_RQDPC (RX_PRIORITY_QUEUE));
+
+  for (i = 0; i < RX_PRIORITY_ETQF_COUNT; i++) {
+    E1000_WRITE_REG (
+      &AdapterInfo->Hw,
+      E1000_ETQF (RX_PRIORITY_ETQF_FIRST + i),
+      E1000_ETQF_FILTER_ENABLE | E1000_ETQF_QUEUE_ENABLE |
+      ((RX_PRIORITY_QUEUE << E1000_ETQF_QUEUE_SHIFT) & E1000_ETQF_QUEUE_MASK) |
+      mRxPriorityEtherTypes[i]
+      );
+  }
+
+  E1000PciFlush (&AdapterInfo->Hw);
+  Ring->IsRunning = TRUE;
+}
+
+/** Returns control traffic to the main ring and disables the priority Rx queue.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Priority queue disabled
+**/
+VOID
+RxPriorityRingDisable (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_PRIORITY_RING  *Ring;
+  UINT32            TempReg;
+  UINTN             i;
+
+  Ring = &AdapterInfo->PriorityRxRing;
+
+  if (!Ring->IsRunning) {
+    return;
+  }
+
+  for (i = 0; i < RX_PRIORITY_ETQF_COUNT; i++) {
+    E1000_WRITE_REG (&AdapterInfo->Hw, E1000_ETQF (RX_PRIORITY_ETQF_FIRST + i), 0);
+  }
+
+  RxPriorityRingUpdateCounters (AdapterInfo);
+
+  E1000ClearRegBits (AdapterInfo, E1000_RXDCTL (RX_PRIORITY_QUEUE), E1000_RXDCTL_QUEUE_ENABLE);
+
+  i = 0;
+  do {
+    gBS->Stall (1);
+    TempReg = E1000_READ_REG (&AdapterInfo->Hw, E1000_RXDCTL (RX_PRIORITY_QUEUE));
+
+    i++;
+    if (i >= MAX_QUEUE_ENABLE_TIME) {
+      break;
+    }
+  } while (BIT_TEST (TempReg, E1000_RXDCTL_QUEUE_ENABLE));
+
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDT (RX_PRIORITY_QUEUE), 0);
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDH (RX_PRIORITY_QUEUE), 0);
+
+  Ring->IsRunning = FALSE;
+}
+
+/** Checks whether the priority Rx queue holds a packet.
+
+   @param[in]    AdapterInfo    Pointer to the NIC data structure
+   @param[out]   PacketLength   On output, length of received packet
+
+   @retval   EFI_SUCCESS     Packet ready
+   @retval   EFI_NOT_READY   No packet in the priority queue
+**/
+EFI_STATUS
+RxPriorityRingIsPacketReady (
+  IN  DRIVER_DATA *AdapterInfo,
+  OUT UINT16      *PacketLength
+  )
+{
+  RX_PRIORITY_RING    *Ring;
+  RECEIVE_DESCRIPTOR  *RxDesc;
+
+  Ring = &AdapterInfo->PriorityRxRing;
+
+  if (!Ring->IsRunning) {
+    return EFI_NOT_READY;
+  }
+
+  RxDesc = PRIORITY_DESCRIPTOR_VA (Ring, Ring->NextToUse);
+  if (!ReceiveIsDescriptorDone (RxDesc, PacketLength, NULL, NULL, NULL)) {
+    return EFI_NOT_READY;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Takes a packet from the priority Rx queue.
+
+   @param[in]      AdapterInfo    Pointer to the NIC data structure
+   @param[out]     Buffer         Buffer to hold received packet
+   @param[in,out]  BufferSize     On input, length of provided buffer.
+                                  On output, number of bytes transferred.
+   @param[out]     PacketLength   On output, full length of received packet
+
+   @retval   EFI_SUCCESS        Packet received
+   @retval   EFI_NOT_READY      No packet in the priority queue
+   @retval   EFI_DEVICE_ERROR   Error reported via Rx descriptor
+**/
+EFI_STATUS
+RxPriorityRingGetPacket (
+  IN     DRIVER_DATA *AdapterInfo,
+  OUT    UINT8       *Buffer,
+  IN OUT UINT16      *BufferSize,
+  OUT    UINT16      *PacketLength
+  )
+{
+  RX_PRIORITY_RING    *Ring;
+  RECEIVE_DESCRIPTOR  *RxDesc;
+  EFI_STATUS          Status;
+  UINT8               RxError;
+  UINT16              LengthToCopy;
+
+  Ring = &AdapterInfo->PriorityRxRing;
+
+  if (!Ring->IsRunning) {
+    return EFI_NOT_READY;
+  }
+
+  RxDesc = PRIORITY_DESCRIPTOR_VA (Ring, Ring->NextToUse);
+  if (!ReceiveIsDescriptorDone (RxDesc, PacketLength, NULL, &RxError, NULL)) {
+    return EFI_NOT_READY;
+  }
+
+  if ((RxError != 0)
+    || (*PacketLength < MIN_ETHERNET_PACKET_LENGTH)
+    || (*PacketLength > RX_BUFFER_SIZE))
+  {
+    DEBUGPRINT (RX, ("Priority Rx error %d, length %d\n", RxError, *PacketLength));
+    Status = EFI_DEVICE_ERROR;
+  } else {
+    LengthToCopy = MIN (*PacketLength, *BufferSize);
+    CopyMem (
+      Buffer,
+      PRIORITY_BUFFER_VA (Ring, Ring->NextToUse),
+      LengthToCopy
+      );
+    *BufferSize = LengthToCopy;
+    Ring->FramesReceived++;
+    Status = EFI_SUCCESS;
+  }
+
+  // Give the descriptor back to the NIC
+  ReceiveAttachBufferToDescriptor (RxDesc, PRIORITY_BUFFER_PA (Ring, Ring->NextToUse));
+  E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDT (RX_PRIORITY_QUEUE), Ring->NextToUse);
+
+  if (++Ring->NextToUse == RX_PRIORITY_DESCRIPTORS) {
+    Ring->NextToUse = 0;
+  }
+
+  return Status;
+}
+
+/** Accumulates the drop counter of the priority Rx queue.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   AdapterInfo->PriorityRxRing counters updated
+**/
+VOID
+RxPriorityRingUpdateCounters (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_PRIORITY_RING  *Ring;
+
+  Ring = &AdapterInfo->PriorityRxRing;
+
+  if (!Ring->IsRunning) {
+    return;
+  }
+
+  // RQDPC is clear on read
+  Ring->FramesDropped += E1000_READ_REG (&AdapterInfo->Hw, E1000_RQDPC (RX_PRIORITY_QUEUE));
+
+  DEBUGPRINT (
+    RX, ("Priority Rx queue: %ld received, %ld dropped\n",
+    Ring->FramesReceived,
+    Ring->FramesDropped)
+  );
+}
+
 /**
   Configure NIC to be ready to use initialized Rx queue.
 
@@ -160,7 +618,9 @@ ReceiveConfigureQueue (
 #ifndef NO_82575_SUPPORT
   switch (AdapterInfo->Hw.mac.type) {
   case e1000_82575:
+#ifndef NO_82576_SUPPORT
   case e1000_82576:
+#endif /* !NO_82576_SUPPORT */
 #ifndef NO_82580_SUPPORT
   case e1000_82580:
 #endif /* !NO_82580_SUPPORT */
@@ -180,6 +640,7 @@ ReceiveConfigureQueue (
 
   E1000_WRITE_REG (&AdapterInfo->Hw, E1000_MRQC, 0);
 
+  RxPriorityRingConfigure (AdapterInfo);
 
   E1000PciFlush (&AdapterInfo->Hw);
   return EFI_SUCCESS;
@@ -236,6 +697,8 @@ ReceiveEnableQueue (
 
     E1000_WRITE_REG (&AdapterInfo->Hw, E1000_RDH (0), 0);
     // Note: RxRing->NextToUse is by default reset to 0.
+
+    RxPriorityRingEnable (AdapterInfo);
     break;
 #endif /* !NO_82575_SUPPORT */
   default:
@@ -282,6 +745,8 @@ ReceiveDisableQueue (
   case e1000_i354:
   case e1000_i210:
   case e1000_i211:
+    RxPriorityRingDisable (AdapterInfo);
+
     E1000ClearRegBits (AdapterInfo, E1000_RXDCTL (0), E1000_RXDCTL_QUEUE_ENABLE);
 
     i = 0;
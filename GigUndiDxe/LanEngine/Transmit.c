@@ -309,10 +309,12 @@ TransmitInitialize (
   TxRing->BufferCount = BufferCount;
 
   // Allocate Tx descriptors
-  TxRing->Descriptors.Size = ALIGN (TxRing->BufferCount * sizeof (TRANSMIT_DESCRIPTOR), 4096);
+  TxRing->Descriptors.Size = TxRing->BufferCount * sizeof (TRANSMIT_DESCRIPTOR);
 
-  Status = UndiDmaAllocateCommonBuffer (
+  Status = UndiDmaRegionAllocate (
              PCI_IO_FROM_ADAPTER (AdapterInfo),
+             &AdapterInfo->DmaRegion,
+             UNDI_DMA_RING_ALIGN,
              &TxRing->Descriptors
              );
 
@@ -370,7 +372,7 @@ ExitFreeBufferEntries:
   TxRing->BufferEntries = NULL;
 
 ExitFreeDesc:
-  UndiDmaFreeCommonBuffer (
+  UndiDmaRegionFree (
     PCI_IO_FROM_ADAPTER (AdapterInfo),
     &TxRing->Descriptors
     );
@@ -622,7 +624,7 @@ TransmitCleanup (
     return Status;
   }
 
-  Status = UndiDmaFreeCommonBuffer (
+  Status = UndiDmaRegionFree (
              PCI_IO_FROM_ADAPTER (AdapterInfo),
              &TxRing->Descriptors
              );
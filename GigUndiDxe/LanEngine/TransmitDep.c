@@ -64,19 +64,22 @@ TransmitSetupDescriptor (
   IN  UINT16                 PacketLength
   )
 {
+  TRANSMIT_DESCRIPTOR Desc;
+
   ASSERT (AdapterInfo != NULL);
   ASSERT (TxDesc != NULL);
   ASSERT (Packet != 0);
   ASSERT (PacketLength != 0);
 
-  TxDesc->buffer_addr         = Packet;
-  TxDesc->upper.fields.status = 0;
-  TxDesc->lower.flags.length  = PacketLength;
-
+  // Assembled locally and written out whole
+  Desc.buffer_addr = Packet;
+  Desc.lower.data  = (UINT32) PacketLength |
+                     E1000_TXD_CMD_EOP |
+                     E1000_TXD_CMD_IFCS |
+                     E1000_TXD_CMD_RS;
+  Desc.upper.data  = 0;
 
-  TxDesc->lower.data |= (E1000_TXD_CMD_EOP |
-                         E1000_TXD_CMD_IFCS |
-                         E1000_TXD_CMD_RS);
+  UndiDmaDescriptorWrite (TxDesc, &Desc);
 }
 
 /**
@@ -0,0 +1,548 @@
+/**************************************************************************
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************/
+
+#include "CommonDriver.h"
+#include "Forms/HiiFormDefs.h"
+
+/* L2 control protocols a boot client never consumes */
+STATIC UINT16 mRxDropEtherTypes[RX_DROP_ETQF_COUNT] = {
+  0x88CC, // LLDP
+  0x8809, // Slow protocols (LACP, marker, OAM)
+  0x88F7, // PTP
+  0x88E3  // Media redundancy protocol
+};
+
+/** Checks whether the MAC provides EtherType queue filters.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @retval   TRUE    ETQF filters available
+   @retval   FALSE   ETQF filters not available
+**/
+BOOLEAN
+RxDropPolicyHasEtherTypeFilters (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  // i211 has two Rx queues only, both in use
+  switch (AdapterInfo->Hw.mac.type) {
+#ifndef NO_82575_SUPPORT
+#ifndef NO_82576_SUPPORT
+  case e1000_82576:
+#endif /* !NO_82576_SUPPORT */
+#ifndef NO_82580_SUPPORT
+  case e1000_82580:
+#endif /* !NO_82580_SUPPORT */
+  case e1000_i350:
+  case e1000_i354:
+#ifndef NO_I210_SUPPORT
+  case e1000_i210:
+#endif /* !NO_I210_SUPPORT */
+    return TRUE;
+#endif /* !NO_82575_SUPPORT */
+  default:
+    return FALSE;
+  }
+}
+
+/** Reads the persisted receive drop policy of the port.
+
+   Falls back to RX_DROP_POLICY_DISABLED when nothing was stored yet.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   AdapterInfo->RxDropPolicy.Policy initialized
+**/
+VOID
+RxDropPolicyLoad (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  UINT8      Policy;
+  EFI_STATUS Status;
+
+  Status = E1000PortVariableGet (AdapterInfo, RX_DROP_POLICY_VARIABLE_NAME, &Policy);
+  if (EFI_ERROR (Status)
+    || (Policy > RX_DROP_POLICY_STRICT))
+  {
+    Policy = RX_DROP_POLICY_DISABLED;
+  }
+
+  AdapterInfo->RxDropPolicy.Policy = Policy;
+  DEBUGPRINT (INIT, ("Rx drop policy %d\n", Policy));
+}
+
+/** Persists the receive drop policy of the port and applies it to the
+   hardware if the adapter is in use.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+   @param[in]   Policy        RX_DROP_POLICY_* value
+
+   @retval   EFI_SUCCESS             Policy stored and applied
+   @retval   EFI_INVALID_PARAMETER   Unknown policy
+   @retval   !EFI_SUCCESS            Failed to store the policy
+**/
+EFI_STATUS
+RxDropPolicySet (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT8        Policy
+  )
+{
+  EFI_STATUS Status;
+
+  if (Policy > RX_DROP_POLICY_STRICT) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Policy == AdapterInfo->RxDropPolicy.Policy) {
+    return EFI_SUCCESS;
+  }
+
+  Status = E1000PortVariableSet (AdapterInfo, RX_DROP_POLICY_VARIABLE_NAME, Policy);
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("Failed to store Rx drop policy: %r\n", Status));
+    return Status;
+  }
+
+  AdapterInfo->RxDropPolicy.Policy = Policy;
+
+  if (AdapterInfo->RxDropPolicy.Applied) {
+    RxDropPolicyRemove (AdapterInfo);
+    RxDropPolicyApply (AdapterInfo);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Programs the hardware receive filters according to the selected drop policy.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Filters programmed
+**/
+VOID
+RxDropPolicyApply (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_DROP_POLICY *DropPolicy;
+  UINT32          Manc;
+  UINTN           i;
+
+  DropPolicy = &AdapterInfo->RxDropPolicy;
+
+  if (DropPolicy->Policy == RX_DROP_POLICY_DISABLED) {
+    return;
+  }
+
+  // Steer L2 control protocols to the disabled drop queue
+  if (RxDropPolicyHasEtherTypeFilters (AdapterInfo)) {
+    E1000_WRITE_REG (
+      &AdapterInfo->Hw,
+      E1000_SRRCTL (RX_DROP_QUEUE),
+      E1000_SRRCTL_DESCTYPE_LEGACY | E1000_SRRCTL_DROP_EN
+      );
+    for (i = 0; i < RX_DROP_ETQF_COUNT; i++) {
+      E1000_WRITE_REG (
+        &AdapterInfo->Hw,
+        E1000_ETQF (RX_DROP_ETQF_FIRST + i),
+        E1000_ETQF_FILTER_ENABLE | E1000_ETQF_QUEUE_ENABLE |
+        ((RX_DROP_QUEUE << E1000_ETQF_QUEUE_SHIFT) & E1000_ETQF_QUEUE_MASK) |
+        mRxDropEtherTypes[i]
+        );
+    }
+    // Clear stale counts so only drops caused by the policy are accumulated
+    E1000_READ_REG (&AdapterInfo->Hw, E1000_RQDPC (RX_DROP_QUEUE));
+  }
+
+  // Keep frames addressed to the manageability controller away from the host
+  Manc = E1000_READ_REG (&AdapterInfo->Hw, E1000_MANC);
+  DropPolicy->MngPassThru = (BOOLEAN) ((Manc & E1000_MANC_EN_MNG2HOST) != 0);
+  if (DropPolicy->MngPassThru) {
+    E1000_WRITE_REG (&AdapterInfo->Hw, E1000_MANC, Manc & ~E1000_MANC_EN_MNG2HOST);
+  }
+
+  DropPolicy->Applied = TRUE;
+
+  // Strict policy accepts tagged frames only for VLANs present in VFTA
+  RxVlanFilterUpdateControl (AdapterInfo);
+
+  E1000PciFlush (&AdapterInfo->Hw);
+}
+
+/** Removes the drop policy filters and hands the management pass through
+   back to the firmware in the state it was found.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Filters removed
+**/
+VOID
+RxDropPolicyRemove (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_DROP_POLICY *DropPolicy;
+  UINTN           i;
+
+  DropPolicy = &AdapterInfo->RxDropPolicy;
+
+  if (!DropPolicy->Applied) {
+    return;
+  }
+
+  RxDropPolicyUpdateCounters (AdapterInfo);
+
+  if (RxDropPolicyHasEtherTypeFilters (AdapterInfo)) {
+    for (i = 0; i < RX_DROP_ETQF_COUNT; i++) {
+      E1000_WRITE_REG (&AdapterInfo->Hw, E1000_ETQF (RX_DROP_ETQF_FIRST + i), 0);
+    }
+  }
+
+  if (DropPolicy->MngPassThru) {
+    E1000SetRegBits (AdapterInfo, E1000_MANC, E1000_MANC_EN_MNG2HOST);
+    DropPolicy->MngPassThru = FALSE;
+  }
+
+  DropPolicy->Applied = FALSE;
+
+  RxVlanFilterUpdateControl (AdapterInfo);
+
+  E1000PciFlush (&AdapterInfo->Hw);
+}
+
+/** Accumulates the hardware drop counters of the policy.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   AdapterInfo->RxDropPolicy counters updated
+**/
+VOID
+RxDropPolicyUpdateCounters (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_DROP_POLICY *DropPolicy;
+
+  DropPolicy = &AdapterInfo->RxDropPolicy;
+
+  if (!DropPolicy->Applied
+    || !RxDropPolicyHasEtherTypeFilters (AdapterInfo))
+  {
+    return;
+  }
+
+  // RQDPC is clear on read
+  DropPolicy->EtherTypeDropped += E1000_READ_REG (&AdapterInfo->Hw, E1000_RQDPC (RX_DROP_QUEUE));
+
+  DEBUGPRINT (
+    RX, ("Rx drop policy: %ld dropped by EtherType, %ld delivered\n",
+    DropPolicy->EtherTypeDropped,
+    DropPolicy->FramesDelivered)
+  );
+}
+
+/** Writes a single VLAN filter table register.
+
+   ICH/PCH parts have no write_vfta operation in the shared code, the generic
+   one is used for them.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+   @param[in]   Offset        VFTA register index
+   @param[in]   Value         Value to be written
+
+   @return   VFTA register written
+**/
+VOID
+RxVlanWriteVfta (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT32       Offset,
+  IN UINT32       Value
+  )
+{
+  if (AdapterInfo->Hw.mac.ops.write_vfta == e1000_null_write_vfta) {
+    e1000_write_vfta_generic (&AdapterInfo->Hw, Offset, Value);
+  } else {
+    e1000_write_vfta (&AdapterInfo->Hw, Offset, Value);
+  }
+  AdapterInfo->VlanFilter.VftaWrites++;
+}
+
+/** Notification of a VLAN Config or MNP service binding install, marks the
+   cached VLAN set stale.
+
+   @param[in]   Event     Watch event
+   @param[in]   Context   Pointer to the NIC data structure
+**/
+STATIC
+VOID
+EFIAPI
+RxVlanFilterNotify (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  ((DRIVER_DATA *) Context)->VlanFilter.SetStale = TRUE;
+}
+
+/** Starts watching the network stack for VLANs added to the port and marks
+   the cached VLAN set stale.
+
+   VLAN Config is installed once MNP binds the port, every VLAN added later
+   gets a child handle with its own MNP service binding. Removed VLANs are
+   dropped from the table by the next UNDI Initialize.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @retval   EFI_SUCCESS    Watch started
+   @retval   !EFI_SUCCESS   Failed to create or register the notify event
+**/
+EFI_STATUS
+RxVlanFilterWatchStart (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_VLAN_FILTER *VlanFilter;
+  EFI_STATUS      Status;
+
+  VlanFilter = &AdapterInfo->VlanFilter;
+  VlanFilter->SetStale = TRUE;
+
+  if (VlanFilter->WatchEvent != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  RxVlanFilterNotify,
+                  AdapterInfo,
+                  &VlanFilter->WatchEvent
+                );
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("CreateEvent returns %r\n", Status));
+    VlanFilter->WatchEvent = NULL;
+    return Status;
+  }
+
+  Status = gBS->RegisterProtocolNotify (
+                  &gEfiVlanConfigProtocolGuid,
+                  VlanFilter->WatchEvent,
+                  &VlanFilter->VlanConfigRegistration
+                );
+  if (!EFI_ERROR (Status)) {
+    Status = gBS->RegisterProtocolNotify (
+                    &gEfiManagedNetworkServiceBindingProtocolGuid,
+                    VlanFilter->WatchEvent,
+                    &VlanFilter->MnpRegistration
+                  );
+  }
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("RegisterProtocolNotify returns %r\n", Status));
+    gBS->CloseEvent (VlanFilter->WatchEvent);
+    VlanFilter->WatchEvent = NULL;
+  }
+
+  return Status;
+}
+
+/** Stops watching the network stack for VLANs added to the port.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+**/
+VOID
+RxVlanFilterWatchStop (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  if (AdapterInfo->VlanFilter.WatchEvent != NULL) {
+    gBS->CloseEvent (AdapterInfo->VlanFilter.WatchEvent);
+    AdapterInfo->VlanFilter.WatchEvent = NULL;
+  }
+}
+
+/** Reads the VLANs configured on the port from the VLAN Config protocol of the
+   network stack and caches them as a VLAN filter table image, if the cached
+   set is stale.
+
+   Called without the Tx/Rx lock held, the protocol allocates the returned
+   list.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   VlanFilter.Wanted and VlanFilter.VlanCount updated
+**/
+VOID
+RxVlanFilterRefresh (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_VLAN_FILTER            *VlanFilter;
+  UNDI_PRIVATE_DATA         *UndiPrivateData;
+  EFI_VLAN_CONFIG_PROTOCOL  *VlanConfig;
+  EFI_VLAN_FIND_DATA        *Entries;
+  UINT16                     VlanCount;
+  UINT16                     VlanId;
+  EFI_STATUS                 Status;
+  UINTN                      i;
+
+  VlanFilter      = &AdapterInfo->VlanFilter;
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_DRIVER_DATA (AdapterInfo);
+  Entries         = NULL;
+  VlanCount       = 0;
+
+  if (!VlanFilter->SetStale) {
+    return;
+  }
+
+  // Cleared first, a notification during the read is not lost
+  VlanFilter->SetStale = FALSE;
+
+  Status = gBS->HandleProtocol (
+                  UndiPrivateData->DeviceHandle,
+                  &gEfiVlanConfigProtocolGuid,
+                  (VOID **) &VlanConfig
+                  );
+  if (!EFI_ERROR (Status)) {
+    Status = VlanConfig->Find (VlanConfig, NULL, &VlanCount, &Entries);
+    if (EFI_ERROR (Status)) {
+      // EFI_NOT_FOUND when the port has no VLANs
+      VlanCount = 0;
+      Entries   = NULL;
+    }
+  }
+
+  ZeroMem (VlanFilter->Wanted, sizeof (VlanFilter->Wanted));
+  for (i = 0; i < VlanCount; i++) {
+    VlanId = Entries[i].VlanId & RX_VLAN_VID_MASK;
+    VlanFilter->Wanted[VlanId >> 5] |= 1 << (VlanId & 0x1F);
+  }
+
+  if (Entries != NULL) {
+    FreePool (Entries);
+  }
+
+  // Priority tagged frames belong to the untagged network
+  VlanFilter->Wanted[0] |= 1;
+  VlanFilter->VlanCount  = VlanCount;
+}
+
+/** Programs the VLAN filter table cached by RxVlanFilterRefresh and updates
+   VLAN filtering accordingly.
+
+   Only registers that differ from the programmed table are written, so the
+   call is cheap when the VLAN set did not change.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   VLAN filtering programmed
+**/
+VOID
+RxVlanFilterUpdate (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  RX_VLAN_FILTER *VlanFilter;
+  BOOLEAN         Written;
+  UINTN           i;
+
+  VlanFilter = &AdapterInfo->VlanFilter;
+  Written    = FALSE;
+
+  for (i = 0; i < E1000_VLAN_FILTER_TBL_SIZE; i++) {
+    if (!VlanFilter->VftaValid
+      || (VlanFilter->Wanted[i] != VlanFilter->Vfta[i]))
+    {
+      RxVlanWriteVfta (AdapterInfo, (UINT32) i, VlanFilter->Wanted[i]);
+      VlanFilter->Vfta[i] = VlanFilter->Wanted[i];
+      Written = TRUE;
+    }
+  }
+
+  if (Written) {
+    E1000PciFlush (&AdapterInfo->Hw);
+    DEBUGPRINT (
+      RX, ("VLAN filter: %d VLANs, %d VFTA writes\n",
+      VlanFilter->VlanCount,
+      VlanFilter->VftaWrites)
+    );
+  }
+
+  VlanFilter->VftaValid = TRUE;
+
+  RxVlanFilterUpdateControl (AdapterInfo);
+}
+
+/** Enables or disables VLAN filtering (RCTL.VFE) according to the configured
+   VLANs, drop policy and receive filters.
+
+   VLAN mode (CTRL.VME) stays off, frames are filtered by the VLAN filter
+   table and handed over with their tags as they were on the wire.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   RCTL.VFE updated
+**/
+VOID
+RxVlanFilterUpdateControl (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  BOOLEAN StrictPolicy;
+  BOOLEAN FilterVlans;
+
+  StrictPolicy = (BOOLEAN) (AdapterInfo->RxDropPolicy.Applied
+                            && (AdapterInfo->RxDropPolicy.Policy == RX_DROP_POLICY_STRICT));
+
+  // Untagged setups see no change unless the strict policy asks for it,
+  // promiscuous mode has to see foreign VLANs too
+  FilterVlans = (BOOLEAN) (((AdapterInfo->VlanFilter.VlanCount != 0) || StrictPolicy)
+                           && AdapterInfo->VlanFilter.VftaValid
+                           && !BIT_TEST (AdapterInfo->RxFilter, PXE_OPFLAGS_RECEIVE_FILTER_PROMISCUOUS));
+
+  if (FilterVlans) {
+    E1000SetRegBits (AdapterInfo, E1000_RCTL, E1000_RCTL_VFE);
+  } else {
+    E1000ClearRegBits (AdapterInfo, E1000_RCTL, E1000_RCTL_VFE);
+  }
+}
+
+/** Marks the VLAN filter table as lost after the hardware was reset.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Next update rewrites the whole table
+**/
+VOID
+RxVlanFilterInvalidate (
+  IN DRIVER_DATA *AdapterInfo
+  )
+{
+  AdapterInfo->VlanFilter.VftaValid = FALSE;
+}
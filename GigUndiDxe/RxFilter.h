@@ -0,0 +1,209 @@
+/**************************************************************************
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***************************************************************************/
+#ifndef RX_FILTER_H_
+#define RX_FILTER_H_
+
+#include "CommonDriver.h"
+
+/* Rx queue frames dropped by the policy are steered to. The queue is never
+   enabled, so the hardware discards them and counts them in RQDPC. */
+#define RX_DROP_QUEUE              2
+
+/* ETQF filters used by the drop policy */
+#define RX_DROP_ETQF_FIRST         0
+#define RX_DROP_ETQF_COUNT         4
+
+#define RX_DROP_POLICY_VARIABLE_NAME  L"RxDropPolicy"
+
+/* VLAN ID bits of the tag control information */
+#define RX_VLAN_VID_MASK           0x0FFF
+
+typedef struct {
+  UINT8   Policy;         // RX_DROP_POLICY_* currently selected
+  BOOLEAN Applied;        // policy programmed into the hardware
+  BOOLEAN MngPassThru;    // MANC.EN_MNG2HOST was set before the policy cleared it
+  UINT64  EtherTypeDropped; // frames discarded by the EtherType filters
+  UINT64  FramesDelivered;  // frames handed to the network stack
+} RX_DROP_POLICY;
+
+typedef struct {
+  UINT32    Vfta[E1000_VLAN_FILTER_TBL_SIZE];   // VLAN filter table as programmed
+  UINT32    Wanted[E1000_VLAN_FILTER_TBL_SIZE]; // VLAN filter table for the configured VLANs
+  BOOLEAN   VftaValid;      // Vfta matches the hardware
+  BOOLEAN   SetStale;       // Wanted has to be read again from VLAN Config
+  UINT16    VlanCount;      // VLANs configured on the port
+  UINT32    VftaWrites;     // VFTA registers written
+  EFI_EVENT WatchEvent;     // signalled when the network stack may have added a VLAN
+  VOID      *VlanConfigRegistration;
+  VOID      *MnpRegistration;
+} RX_VLAN_FILTER;
+
+/** Reads the persisted receive drop policy of the port.
+
+   Falls back to RX_DROP_POLICY_DISABLED when nothing was stored yet.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   AdapterInfo->RxDropPolicy.Policy initialized
+**/
+VOID
+RxDropPolicyLoad (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Persists the receive drop policy of the port and applies it to the
+   hardware if the adapter is in use.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+   @param[in]   Policy        RX_DROP_POLICY_* value
+
+   @retval   EFI_SUCCESS             Policy stored and applied
+   @retval   EFI_INVALID_PARAMETER   Unknown policy
+   @retval   !EFI_SUCCESS            Failed to store the policy
+**/
+EFI_STATUS
+RxDropPolicySet (
+  IN DRIVER_DATA *AdapterInfo,
+  IN UINT8        Policy
+  );
+
+/** Programs the hardware receive filters according to the selected drop policy.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Filters programmed
+**/
+VOID
+RxDropPolicyApply (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Removes the drop policy filters and hands the management pass through
+   back to the firmware in the state it was found.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Filters removed
+**/
+VOID
+RxDropPolicyRemove (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Accumulates the hardware drop counters of the policy.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   AdapterInfo->RxDropPolicy counters updated
+**/
+VOID
+RxDropPolicyUpdateCounters (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Starts watching the network stack for VLANs added to the port and marks
+   the cached VLAN set stale.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @retval   EFI_SUCCESS    Watch started
+   @retval   !EFI_SUCCESS   Failed to create or register the notify event
+**/
+EFI_STATUS
+RxVlanFilterWatchStart (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Stops watching the network stack for VLANs added to the port.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+**/
+VOID
+RxVlanFilterWatchStop (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Reads the VLANs configured on the port from the VLAN Config protocol of the
+   network stack and caches them as a VLAN filter table image, if the cached
+   set is stale.
+
+   Called without the Tx/Rx lock held, the protocol allocates the returned
+   list.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   VlanFilter.Wanted and VlanFilter.VlanCount updated
+**/
+VOID
+RxVlanFilterRefresh (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Programs the VLAN filter table cached by RxVlanFilterRefresh and updates
+   VLAN filtering accordingly.
+
+   Only registers that differ from the programmed table are written, so the
+   call is cheap when the VLAN set did not change.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   VLAN filtering programmed
+**/
+VOID
+RxVlanFilterUpdate (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Enables or disables VLAN filtering (RCTL.VFE) according to the configured
+   VLANs, drop policy and receive filters.
+
+   VLAN mode (CTRL.VME) stays off, frames are filtered by the VLAN filter
+   table and handed over with their tags as they were on the wire.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   RCTL.VFE updated
+**/
+VOID
+RxVlanFilterUpdateControl (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+/** Marks the VLAN filter table as lost after the hardware was reset.
+
+   @param[in]   AdapterInfo   Pointer to the NIC data structure
+
+   @return   Next update rewrites the whole table
+**/
+VOID
+RxVlanFilterInvalidate (
+  IN DRIVER_DATA *AdapterInfo
+  );
+
+#endif /* RX_FILTER_H_ */
@@ -71,6 +71,7 @@ StartDriver (
   EFI_STATUS         Status = EFI_SUCCESS;
   UNDI_PRIVATE_DATA *GigPrivate;
   BOOLEAN            ReceiveStarted;
+  BOOLEAN            HealthPaused;
 
   DEBUGPRINT (DIAG, ("Entering StartDriver\n"));
   DEBUGWAIT (DIAG);
@@ -80,8 +81,10 @@ StartDriver (
   // Save off the value of ReceiveStarted as it will be reset by InitializeGigUNDIDriver
   ReceiveStarted = GigPrivate->NicInfo.RxRing.IsRunning;
 
+  HealthPaused = HealthMonitorPause (GigPrivate);
   GigPrivate->NicInfo.HwInitialized = FALSE;
   e1000_reset_hw (&GigPrivate->NicInfo.Hw);
+  HealthMonitorResume (GigPrivate, HealthPaused);
   if (GigPrivate->NicInfo.State == PXE_STATFLAGS_GET_STATE_INITIALIZED
     && GigPrivate->IsChildInitialized)
   {
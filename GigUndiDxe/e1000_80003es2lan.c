@@ -400,12 +400,11 @@ STATIC s32 e1000_acquire_swfw_sync_80003es2lan(struct e1000_hw *hw, u16 mask)
 	u32 swfw_sync;
 	u32 swmask = mask;
 	u32 fwmask = mask << 16;
-	s32 i = 0;
-	s32 timeout = 50;
+	u32 waited = 0;
 
 	DEBUGFUNC("e1000_acquire_swfw_sync_80003es2lan");
 
-	while (i < timeout) {
+	while (waited < E1000_SWFW_SYNC_BUDGET_80003ES2LAN_USEC) {
 		if (e1000_get_hw_semaphore_generic(hw))
 			return -E1000_ERR_SWFW_SYNC;
 
@@ -417,11 +416,12 @@ STATIC s32 e1000_acquire_swfw_sync_80003es2lan(struct e1000_hw *hw, u16 mask)
 		 * or other software thread using resource (swmask)
 		 */
 		e1000_put_hw_semaphore_generic(hw);
-		msec_delay_irq(5);
-		i++;
+		msec_delay_irq(E1000_SWFW_SYNC_DELAY_USEC / 1000);
+		waited += E1000_SWFW_SYNC_DELAY_USEC;
 	}
 
-	if (i == timeout) {
+	if (waited >= E1000_SWFW_SYNC_BUDGET_80003ES2LAN_USEC) {
+		e1000_sync_account(hw, waited, false);
 		DEBUGOUT("Driver can't access resource, SW_FW_SYNC timeout.\n");
 		return -E1000_ERR_SWFW_SYNC;
 	}
@@ -430,6 +430,7 @@ STATIC s32 e1000_acquire_swfw_sync_80003es2lan(struct e1000_hw *hw, u16 mask)
 	E1000_WRITE_REG(hw, E1000_SW_FW_SYNC, swfw_sync);
 
 	e1000_put_hw_semaphore_generic(hw);
+	e1000_sync_account(hw, waited, true);
 
 	return E1000_SUCCESS;
 }
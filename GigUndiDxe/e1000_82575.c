@@ -1069,11 +1069,11 @@ STATIC s32 e1000_acquire_swfw_sync_82575(struct e1000_hw *hw, u16 mask)
 	u32 swmask = mask;
 	u32 fwmask = mask << 16;
 	s32 ret_val = E1000_SUCCESS;
-	s32 i = 0, timeout = 200;
+	u32 waited = 0;
 
 	DEBUGFUNC("e1000_acquire_swfw_sync_82575");
 
-	while (i < timeout) {
+	while (waited < E1000_SWFW_SYNC_BUDGET_USEC) {
 		if (e1000_get_hw_semaphore_generic(hw)) {
 			ret_val = -E1000_ERR_SWFW_SYNC;
 			goto out;
@@ -1088,11 +1088,12 @@ STATIC s32 e1000_acquire_swfw_sync_82575(struct e1000_hw *hw, u16 mask)
 		 * or other software thread using resource (swmask)
 		 */
 		e1000_put_hw_semaphore_generic(hw);
-		msec_delay_irq(5);
-		i++;
+		msec_delay_irq(E1000_SWFW_SYNC_DELAY_USEC / 1000);
+		waited += E1000_SWFW_SYNC_DELAY_USEC;
 	}
 
-	if (i == timeout) {
+	if (waited >= E1000_SWFW_SYNC_BUDGET_USEC) {
+		e1000_sync_account(hw, waited, false);
 		DEBUGOUT("Driver can't access resource, SW_FW_SYNC timeout.\n");
 		ret_val = -E1000_ERR_SWFW_SYNC;
 		goto out;
@@ -1102,6 +1103,7 @@ STATIC s32 e1000_acquire_swfw_sync_82575(struct e1000_hw *hw, u16 mask)
 	E1000_WRITE_REG(hw, E1000_SW_FW_SYNC, swfw_sync);
 
 	e1000_put_hw_semaphore_generic(hw);
+	e1000_sync_account(hw, waited, true);
 
 out:
 	return ret_val;
@@ -1284,6 +1286,8 @@ STATIC s32 e1000_check_for_link_media_swap(struct e1000_hw *hw)
 	if (port && (hw->dev_spec._82575.media_port != port)) {
 		hw->dev_spec._82575.media_port = port;
 		hw->dev_spec._82575.media_changed = true;
+		/* The SFP cage may be on the other port */
+		hw->dev_spec._82575.sfp_cache_valid = false;
 	}
 
 	if (port == E1000_MEDIA_PORT_COPPER) {
@@ -1448,6 +1452,9 @@ STATIC s32 e1000_reset_hw_82575(struct e1000_hw *hw)
 
 	DEBUGFUNC("e1000_reset_hw_82575");
 
+	/* The module may be swapped while the port is reset */
+	hw->dev_spec._82575.sfp_cache_valid = false;
+
 	/*
 	 * Prevent the PCI-E bus from sticking if there is no TLP connection
 	 * on the last TLP read/write transaction when MAC is reset.
@@ -1877,21 +1884,26 @@ STATIC s32 e1000_get_media_type_82575(struct e1000_hw *hw)
 }
 
 /**
- *  e1000_set_sfp_media_type_82575 - derives SFP module media type.
+ *  e1000_read_sfp_cache_82575 - Reads SFP module ID page into the cache
  *  @hw: pointer to the HW structure
  *
- *  The media type is chosen based on SFP module.
- *  compatibility flags retrieved from SFP ID EEPROM.
+ *  Reads the base ID fields of the SFP A0h page with I2C block transfers
+ *  unless the cache is already valid.  The cache is dropped by reset_hw,
+ *  by media type detection, when e1000_check_sfp_module_82575 detects a
+ *  module presence change and when the media port is swapped.
  **/
-STATIC s32 e1000_set_sfp_media_type_82575(struct e1000_hw *hw)
+s32 e1000_read_sfp_cache_82575(struct e1000_hw *hw)
 {
-	s32 ret_val = E1000_ERR_CONFIG;
-	u32 ctrl_ext = 0;
 	struct e1000_dev_spec_82575 *dev_spec = &hw->dev_spec._82575;
-	struct sfp_e1000_flags *eth_flags = &dev_spec->eth_flags;
-	u8 tranceiver_type = 0;
+	s32 ret_val = -E1000_ERR_CONFIG;
+	u32 ctrl_ext = 0;
 	s32 timeout = 3;
 
+	DEBUGFUNC("e1000_read_sfp_cache_82575");
+
+	if (dev_spec->sfp_cache_valid)
+		return E1000_SUCCESS;
+
 	/* Turn I2C interface ON and power on sfp cage */
 	ctrl_ext = E1000_READ_REG(hw, E1000_CTRL_EXT);
 	ctrl_ext &= ~E1000_CTRL_EXT_SDP3_DATA;
@@ -1899,25 +1911,93 @@ STATIC s32 e1000_set_sfp_media_type_82575(struct e1000_hw *hw)
 
 	E1000_WRITE_FLUSH(hw);
 
+	dev_spec->sfp_read_usec = 0;
+
 	/* Read SFP module data */
 	while (timeout) {
-		ret_val = e1000_read_sfp_data_byte(hw,
-			E1000_I2CCMD_SFP_DATA_ADDR(E1000_SFF_IDENTIFIER_OFFSET),
-			&tranceiver_type);
+		ret_val = e1000_read_sfp_data_block(hw,
+				E1000_I2CCMD_SFP_DATA_ADDR(0),
+				dev_spec->sfp_cache, E1000_SFF_CACHE_SIZE,
+				&dev_spec->sfp_read_usec);
 		if (ret_val == E1000_SUCCESS)
 			break;
 		msec_delay(100);
 		timeout--;
 	}
-	if (ret_val != E1000_SUCCESS)
-		goto out;
+
+	if (ret_val == E1000_SUCCESS) {
+		dev_spec->sfp_cache_valid = true;
+		DEBUGOUT2("SFP cache: %u bytes read in %u usec\n",
+			  E1000_SFF_CACHE_SIZE, dev_spec->sfp_read_usec);
+	}
+
+	/* Restore I2C interface setting */
+	E1000_WRITE_REG(hw, E1000_CTRL_EXT, ctrl_ext);
+	return ret_val;
+}
+
+/**
+ *  e1000_check_sfp_module_82575 - Invalidates SFP cache on module change
+ *  @hw: pointer to the HW structure
+ *
+ *  Reads only the SFP identifier byte and drops the cache if it does not
+ *  match the cached one, i.e. if a module was inserted or removed.
+ **/
+s32 e1000_check_sfp_module_82575(struct e1000_hw *hw)
+{
+	struct e1000_dev_spec_82575 *dev_spec = &hw->dev_spec._82575;
+	u8 tranceiver_type = 0;
+	u32 ctrl_ext = 0;
+	s32 ret_val;
+
+	DEBUGFUNC("e1000_check_sfp_module_82575");
+
+	if (!dev_spec->sfp_cache_valid)
+		return E1000_SUCCESS;
+
+	ctrl_ext = E1000_READ_REG(hw, E1000_CTRL_EXT);
+	E1000_WRITE_REG(hw, E1000_CTRL_EXT, ctrl_ext | E1000_CTRL_I2C_ENA);
+	E1000_WRITE_FLUSH(hw);
 
 	ret_val = e1000_read_sfp_data_byte(hw,
-			E1000_I2CCMD_SFP_DATA_ADDR(E1000_SFF_ETH_FLAGS_OFFSET),
-			(u8 *)eth_flags);
+			E1000_I2CCMD_SFP_DATA_ADDR(E1000_SFF_IDENTIFIER_OFFSET),
+			&tranceiver_type);
+	if ((ret_val != E1000_SUCCESS) ||
+	    (tranceiver_type !=
+	     dev_spec->sfp_cache[E1000_SFF_IDENTIFIER_OFFSET])) {
+		DEBUGOUT("SFP module presence changed\n");
+		dev_spec->sfp_cache_valid = false;
+	}
+
+	E1000_WRITE_REG(hw, E1000_CTRL_EXT, ctrl_ext);
+	return ret_val;
+}
+
+/**
+ *  e1000_set_sfp_media_type_82575 - derives SFP module media type.
+ *  @hw: pointer to the HW structure
+ *
+ *  The media type is chosen based on SFP module.
+ *  compatibility flags retrieved from SFP ID EEPROM.
+ **/
+STATIC s32 e1000_set_sfp_media_type_82575(struct e1000_hw *hw)
+{
+	s32 ret_val = E1000_ERR_CONFIG;
+	struct e1000_dev_spec_82575 *dev_spec = &hw->dev_spec._82575;
+	struct sfp_e1000_flags *eth_flags = &dev_spec->eth_flags;
+	u8 tranceiver_type = 0;
+
+	/* Media type is derived from the module present now, not a cached one */
+	dev_spec->sfp_cache_valid = false;
+
+	/* Read SFP module data */
+	ret_val = e1000_read_sfp_cache_82575(hw);
 	if (ret_val != E1000_SUCCESS)
 		goto out;
 
+	tranceiver_type = dev_spec->sfp_cache[E1000_SFF_IDENTIFIER_OFFSET];
+	*(u8 *)eth_flags = dev_spec->sfp_cache[E1000_SFF_ETH_FLAGS_OFFSET];
+
 	/* Check if there is some SFP module plugged and powered */
 	if ((tranceiver_type == E1000_SFF_IDENTIFIER_SFP) ||
 	    (tranceiver_type == E1000_SFF_IDENTIFIER_SFF)) {
@@ -1940,8 +2020,6 @@ STATIC s32 e1000_set_sfp_media_type_82575(struct e1000_hw *hw)
 	}
 	ret_val = E1000_SUCCESS;
 out:
-	/* Restore I2C interface setting */
-	E1000_WRITE_REG(hw, E1000_CTRL_EXT, ctrl_ext);
 	return ret_val;
 }
 
@@ -2406,6 +2484,9 @@ STATIC s32 e1000_reset_hw_82580(struct e1000_hw *hw)
 
 	hw->dev_spec._82575.global_device_reset = false;
 
+	/* The module may be swapped while the port is reset */
+	hw->dev_spec._82575.sfp_cache_valid = false;
+
 	/* 82580 does not reliably do global_device_reset due to hw errata */
 	if (hw->mac.type == e1000_82580)
 		global_device_reset = false;
@@ -297,6 +297,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 s32 e1000_reset_init_script_82575(struct e1000_hw *hw);
 s32 e1000_init_nvm_params_82575(struct e1000_hw *hw);
+s32 e1000_read_sfp_cache_82575(struct e1000_hw *hw);
+s32 e1000_check_sfp_module_82575(struct e1000_hw *hw);
 
 /* Rx packet buffer size defines */
 #define E1000_RXPBS_SIZE_MASK_82576	0x0000007F
@@ -606,10 +606,20 @@ s32 e1000_reset_hw(struct e1000_hw *hw)
  **/
 s32 e1000_init_hw(struct e1000_hw *hw)
 {
-	if (hw->mac.ops.init_hw)
-		return hw->mac.ops.init_hw(hw);
+	s32 ret_val;
 
-	return -E1000_ERR_CONFIG;
+	if (!hw->mac.ops.init_hw)
+		return -E1000_ERR_CONFIG;
+
+	hw->phy.mdio_transactions = 0;
+	hw->phy.mdio_usec = 0;
+
+	ret_val = hw->mac.ops.init_hw(hw);
+
+	DEBUGOUT2("init_hw: %u MDIO transactions, %u usec\n",
+		  hw->phy.mdio_transactions, hw->phy.mdio_usec);
+
+	return ret_val;
 }
 
 /**
@@ -1196,10 +1206,16 @@ s32 e1000_read_pba_num(struct e1000_hw *hw, u32 *pba_num)
  **/
 s32 e1000_validate_nvm_checksum(struct e1000_hw *hw)
 {
-	if (hw->nvm.ops.validate)
-		return hw->nvm.ops.validate(hw);
+	s32 ret_val;
 
-	return -E1000_ERR_CONFIG;
+	if (!hw->nvm.ops.validate)
+		return -E1000_ERR_CONFIG;
+
+	ret_val = hw->nvm.ops.validate(hw);
+	if (!ret_val && !hw->nvm.txn.depth)
+		hw->nvm.txn.checksum_valid = true;
+
+	return ret_val;
 }
 
 /**
@@ -1208,13 +1224,28 @@ s32 e1000_validate_nvm_checksum(struct e1000_hw *hw)
  *
  *  Updates the NVM checksum. Currently no func pointer exists and all
  *  implementations are handled in the generic version of this function.
+ *  Inside an NVM transaction the update is deferred to
+ *  e1000_nvm_txn_commit(), so it runs once however often it is requested.
  **/
 s32 e1000_update_nvm_checksum(struct e1000_hw *hw)
 {
-	if (hw->nvm.ops.update)
-		return hw->nvm.ops.update(hw);
+	s32 ret_val;
 
-	return -E1000_ERR_CONFIG;
+	if (!hw->nvm.ops.update)
+		return -E1000_ERR_CONFIG;
+
+	hw->nvm.generation++;
+
+	if (hw->nvm.txn.depth) {
+		hw->nvm.txn.update_pending = true;
+		return E1000_SUCCESS;
+	}
+
+	ret_val = hw->nvm.ops.update(hw);
+	if (!ret_val)
+		hw->nvm.txn.checksum_valid = true;
+
+	return ret_val;
 }
 
 /**
@@ -1242,10 +1273,16 @@ void e1000_reload_nvm(struct e1000_hw *hw)
  **/
 s32 e1000_read_nvm(struct e1000_hw *hw, u16 offset, u16 words, u16 *data)
 {
-	if (hw->nvm.ops.read)
-		return hw->nvm.ops.read(hw, offset, words, data);
+	s32 ret_val;
 
-	return -E1000_ERR_CONFIG;
+	if (!hw->nvm.ops.read)
+		return -E1000_ERR_CONFIG;
+
+	ret_val = hw->nvm.ops.read(hw, offset, words, data);
+	if (!ret_val && hw->nvm.txn.count)
+		e1000_nvm_txn_overlay(hw, offset, words, data);
+
+	return ret_val;
 }
 
 /**
@@ -1260,10 +1297,16 @@ s32 e1000_read_nvm(struct e1000_hw *hw, u16 offset, u16 words, u16 *data)
  **/
 s32 e1000_write_nvm(struct e1000_hw *hw, u16 offset, u16 words, u16 *data)
 {
-	if (hw->nvm.ops.write)
-		return hw->nvm.ops.write(hw, offset, words, data);
+	if (!hw->nvm.ops.write)
+		return E1000_SUCCESS;
 
-	return E1000_SUCCESS;
+	hw->nvm.generation++;
+
+	if (hw->nvm.txn.depth)
+		return e1000_nvm_txn_stage(hw, offset, words, data);
+
+	hw->nvm.txn.checksum_valid = false;
+	return hw->nvm.ops.write(hw, offset, words, data);
 }
 
 #ifndef NO_82575_SUPPORT
@@ -1268,6 +1268,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /* length of string needed to store PBA number */
 #define E1000_PBANUM_LENGTH		11
+#define E1000_PBA_READ_CHUNK		16 /* PBA string words per NVM read */
+#define E1000_NVM_TXN_WORDS		32 /* words staged per NVM transaction */
 
 /* For checksumming, the sum of all words in the NVM should equal 0xBABA. */
 #define NVM_SUM				0xBABA
@@ -1549,6 +1551,20 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif /* NO_82575_SUPPORT */
 #define E1000_GEN_POLL_TIMEOUT		640
 
+/* MDIC completion polling: first poll after the calibrated completion time,
+ * then back off from the minimum to the maximum interval.
+ */
+#define E1000_MDIC_POLL_MIN_USEC	5
+#define E1000_MDIC_POLL_MAX_USEC	50
+#define E1000_MDIC_POLL_BUDGET_USEC	(E1000_GEN_POLL_TIMEOUT * 3 * \
+					 E1000_MDIC_POLL_MAX_USEC)
+
+/* SW_FW_SYNC is polled under SWSM, so retries back off 5 ms at a time */
+#define E1000_SWFW_SYNC_DELAY_USEC	5000
+#define E1000_SWFW_SYNC_BUDGET_USEC	(200 * E1000_SWFW_SYNC_DELAY_USEC)
+#define E1000_SWFW_SYNC_BUDGET_80003ES2LAN_USEC	\
+					(50 * E1000_SWFW_SYNC_DELAY_USEC)
+
 #ifndef NO_82575_SUPPORT
 /* LinkSec register fields */
 #define E1000_LSECTXCAP_SUM_MASK	0x00FF0000
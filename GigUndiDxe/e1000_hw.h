@@ -34,6 +34,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "e1000_defines.h"
 
 struct e1000_hw;
+struct e1000_phy_reg_write;
 
 #ifndef NO_82571_SUPPORT
 #define E1000_DEV_ID_82571EB_COPPER		0x105E
@@ -854,6 +855,29 @@ struct e1000_phy_info {
 #endif
 	bool speed_downgraded;
 	bool autoneg_wait_to_complete;
+
+	u32 mdic_wait_usec;	/* calibrated MDIC completion time */
+	u32 mdio_transactions;
+	u32 mdio_usec;		/* time spent waiting for MDIC */
+	u16 page_shadow;	/* IGP page select last written in a sequence */
+	bool page_shadow_valid;
+	bool in_sequence;
+};
+
+struct e1000_phy_reg_write {
+	u32 offset;
+	u16 data;
+};
+
+struct e1000_nvm_txn {
+	u16 offset[E1000_NVM_TXN_WORDS];
+	u16 data[E1000_NVM_TXN_WORDS];
+	u16 count;		/* words currently staged */
+	u16 sum_delta;		/* change of the 0x00-0x3E word sum */
+	u8 depth;		/* nesting level of e1000_nvm_txn_begin */
+	bool update_pending;	/* checksum update requested in transaction */
+	bool incremental_ok;	/* checksum word untouched, delta is usable */
+	bool checksum_valid;	/* NVM checksum known good since last write */
 };
 
 struct e1000_nvm_info {
@@ -869,6 +893,9 @@ struct e1000_nvm_info {
 	u16 address_bits;
 	u16 opcode_bits;
 	u16 page_size;
+
+	u32 generation;		/* bumped on every write through the API */
+	struct e1000_nvm_txn txn;
 };
 
 struct e1000_bus_info {
@@ -916,6 +943,8 @@ struct e1000_shadow_ram {
 struct e1000_dev_spec_ich8lan {
 	bool kmrn_lock_loss_workaround_enabled;
 	struct e1000_shadow_ram shadow_ram[E1000_SHADOW_RAM_WORDS];
+	u32 nvm_bank;		/* valid bank, cached until the next commit */
+	bool nvm_bank_cached;
 	E1000_MUTEX nvm_mutex;
 	E1000_MUTEX swflag_mutex;
 	bool nvm_k1_enabled;
@@ -936,11 +965,18 @@ struct e1000_dev_spec_82575 {
 	bool module_plugged;
 #ifndef NO_I210_SUPPORT
 	bool clear_semaphore_once;
+	/* iNVM word autoload records indexed by word address */
+	u16 invm_words[E1000_INVM_WORD_ADDRESSES];
+	u32 invm_present[E1000_INVM_WORD_ADDRESSES / 32];
+	bool invm_indexed;
 #endif /* NO_I210_SUPPORT */
 	u32 mtu;
 	struct sfp_e1000_flags eth_flags;
 	u8 media_port;
 	bool media_changed;
+	u8 sfp_cache[E1000_SFF_CACHE_SIZE];
+	bool sfp_cache_valid;
+	u32 sfp_read_usec;
 };
 
 struct e1000_dev_spec_vf {
@@ -949,6 +985,14 @@ struct e1000_dev_spec_vf {
 };
 
 #endif /* NO_82575_SUPPORT */
+struct e1000_sync_info {
+	u32 acquisitions;
+	u32 contended;		/* acquisitions that had to wait */
+	u32 timeouts;
+	u32 wait_usec;		/* total time spent waiting */
+	u32 max_wait_usec;
+};
+
 struct e1000_hw {
 	void *back;
 
@@ -962,6 +1006,7 @@ struct e1000_hw {
 	struct e1000_nvm_info  nvm;
 	struct e1000_bus_info  bus;
 	struct e1000_host_mng_dhcp_cookie mng_cookie;
+	struct e1000_sync_info sync;
 
 	union {
 #ifndef NO_82571_SUPPORT
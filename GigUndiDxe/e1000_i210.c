@@ -85,11 +85,11 @@ s32 e1000_acquire_swfw_sync_i210(struct e1000_hw *hw, u16 mask)
 	u32 swmask = mask;
 	u32 fwmask = mask << 16;
 	s32 ret_val = E1000_SUCCESS;
-	s32 i = 0, timeout = 200; /* FIXME: find real value to use here */
+	u32 waited = 0;
 
 	DEBUGFUNC("e1000_acquire_swfw_sync_i210");
 
-	while (i < timeout) {
+	while (waited < E1000_SWFW_SYNC_BUDGET_USEC) {
 		if (e1000_get_hw_semaphore_i210(hw)) {
 			ret_val = -E1000_ERR_SWFW_SYNC;
 			goto out;
@@ -104,11 +104,12 @@ s32 e1000_acquire_swfw_sync_i210(struct e1000_hw *hw, u16 mask)
 		 * or other software thread using resource (swmask)
 		 */
 		e1000_put_hw_semaphore_generic(hw);
-		msec_delay_irq(5);
-		i++;
+		msec_delay_irq(E1000_SWFW_SYNC_DELAY_USEC / 1000);
+		waited += E1000_SWFW_SYNC_DELAY_USEC;
 	}
 
-	if (i == timeout) {
+	if (waited >= E1000_SWFW_SYNC_BUDGET_USEC) {
+		e1000_sync_account(hw, waited, false);
 		DEBUGOUT("Driver can't access resource, SW_FW_SYNC timeout.\n");
 		ret_val = -E1000_ERR_SWFW_SYNC;
 		goto out;
@@ -118,6 +119,7 @@ s32 e1000_acquire_swfw_sync_i210(struct e1000_hw *hw, u16 mask)
 	E1000_WRITE_REG(hw, E1000_SW_FW_SYNC, swfw_sync);
 
 	e1000_put_hw_semaphore_generic(hw);
+	e1000_sync_account(hw, waited, true);
 
 out:
 	return ret_val;
@@ -241,7 +243,7 @@ s32 e1000_read_nvm_srrd_i210(struct e1000_hw *hw, u16 offset, u16 words,
 		count = (words - i) / E1000_EERD_EEWR_MAX_COUNT > 0 ?
 			E1000_EERD_EEWR_MAX_COUNT : (words - i);
 		if (hw->nvm.ops.acquire(hw) == E1000_SUCCESS) {
-			status = e1000_read_nvm_eerd(hw, offset, count,
+			status = e1000_read_nvm_eerd(hw, offset + i, count,
 						     data + i);
 			hw->nvm.ops.release(hw);
 		} else {
@@ -359,25 +361,30 @@ out:
 	return ret_val;
 }
 
-/** e1000_read_invm_word_i210 - Reads OTP
+/**
+ *  e1000_index_invm_i210 - Build the iNVM word index
  *  @hw: pointer to the HW structure
- *  @address: the word address (aka eeprom offset) to read
- *  @data: pointer to the data read
  *
- *  Reads 16-bit words from the OTP. Return error when the word is not
- *  stored in OTP.
+ *  Walks the iNVM record area once and records the data of every word
+ *  autoload structure by its word address.  The first record for an
+ *  address wins, as it did for the linear search.  Returns the number of
+ *  iNVM data registers read.
  **/
-STATIC s32 e1000_read_invm_word_i210(struct e1000_hw *hw, u8 address, u16 *data)
+STATIC u32 e1000_index_invm_i210(struct e1000_hw *hw)
 {
-	s32 status = -E1000_ERR_INVM_VALUE_NOT_FOUND;
+	struct e1000_dev_spec_82575 *dev_spec = &hw->dev_spec._82575;
 	u32 invm_dword;
+	u32 reads = 0;
 	u16 i;
 	u8 record_type, word_address;
 
-	DEBUGFUNC("e1000_read_invm_word_i210");
+	DEBUGFUNC("e1000_index_invm_i210");
+
+	memset(dev_spec->invm_present, 0, sizeof(dev_spec->invm_present));
 
 	for (i = 0; i < E1000_INVM_SIZE; i++) {
 		invm_dword = E1000_READ_REG(hw, E1000_INVM_DATA_REG(i));
+		reads++;
 		/* Get record type */
 		record_type = INVM_DWORD_TO_RECORD_TYPE(invm_dword);
 		if (record_type == E1000_INVM_UNINITIALIZED_STRUCTURE)
@@ -388,18 +395,48 @@ STATIC s32 e1000_read_invm_word_i210(struct e1000_hw *hw, u8 address, u16 *data)
 			i += E1000_INVM_RSA_KEY_SHA256_DATA_SIZE_IN_DWORDS;
 		if (record_type == E1000_INVM_WORD_AUTOLOAD_STRUCTURE) {
 			word_address = INVM_DWORD_TO_WORD_ADDRESS(invm_dword);
-			if (word_address == address) {
-				*data = INVM_DWORD_TO_WORD_DATA(invm_dword);
-				DEBUGOUT2("Read INVM Word 0x%02x = %x",
-					  address, *data);
-				status = E1000_SUCCESS;
-				break;
-			}
+			if (dev_spec->invm_present[word_address / 32] &
+			    (1U << (word_address % 32)))
+				continue;
+			dev_spec->invm_present[word_address / 32] |=
+				1U << (word_address % 32);
+			dev_spec->invm_words[word_address] =
+				INVM_DWORD_TO_WORD_DATA(invm_dword);
 		}
 	}
-	if (status != E1000_SUCCESS)
+
+	dev_spec->invm_indexed = true;
+
+	return reads;
+}
+
+/** e1000_read_invm_word_i210 - Reads OTP
+ *  @hw: pointer to the HW structure
+ *  @address: the word address (aka eeprom offset) to read
+ *  @data: pointer to the data read
+ *
+ *  Reads 16-bit words from the OTP. Return error when the word is not
+ *  stored in OTP.
+ **/
+STATIC s32 e1000_read_invm_word_i210(struct e1000_hw *hw, u8 address, u16 *data)
+{
+	struct e1000_dev_spec_82575 *dev_spec = &hw->dev_spec._82575;
+
+	DEBUGFUNC("e1000_read_invm_word_i210");
+
+	if (!dev_spec->invm_indexed)
+		e1000_index_invm_i210(hw);
+
+	if ((address >= E1000_INVM_WORD_ADDRESSES) ||
+	    !(dev_spec->invm_present[address / 32] & (1U << (address % 32)))) {
 		DEBUGOUT1("Requested word 0x%02x not found in OTP\n", address);
-	return status;
+		return -E1000_ERR_INVM_VALUE_NOT_FOUND;
+	}
+
+	*data = dev_spec->invm_words[address];
+	DEBUGOUT2("Read INVM Word 0x%02x = %x", address, *data);
+
+	return E1000_SUCCESS;
 }
 
 /** e1000_read_invm_i210 - Read invm wrapper function for I210/I211
@@ -684,6 +721,8 @@ STATIC s32 e1000_init_nvm_params_i210(struct e1000_hw *hw)
 	} else {
 		hw->nvm.type = e1000_nvm_invm;
 		nvm->ops.read     = e1000_read_invm_i210;
+		DEBUGOUT1("iNVM indexed with %u register reads\n",
+			  e1000_index_invm_i210(hw));
 #ifndef NO_NULL_OPS_SUPPORT
 		nvm->ops.write    = e1000_null_write_nvm;
 		nvm->ops.validate = e1000_null_ops_generic;
@@ -1440,6 +1440,7 @@ STATIC void e1000_release_nvm_ich8lan(struct e1000_hw *hw)
 STATIC s32 e1000_acquire_swflag_ich8lan(struct e1000_hw *hw)
 {
 	u32 extcnf_ctrl, timeout = PHY_CFG_TIMEOUT;
+	u32 waited = 0;
 	s32 ret_val = E1000_SUCCESS;
 
 	DEBUGFUNC("e1000_acquire_swflag_ich8lan");
@@ -1452,6 +1453,7 @@ STATIC s32 e1000_acquire_swflag_ich8lan(struct e1000_hw *hw)
 			break;
 
 		msec_delay_irq(1);
+		waited += 1000;
 		timeout--;
 	}
 
@@ -1472,6 +1474,7 @@ STATIC s32 e1000_acquire_swflag_ich8lan(struct e1000_hw *hw)
 			break;
 
 		msec_delay_irq(1);
+		waited += 1000;
 		timeout--;
 	}
 
@@ -1485,6 +1488,7 @@ STATIC s32 e1000_acquire_swflag_ich8lan(struct e1000_hw *hw)
 	}
 
 out:
+	e1000_sync_account(hw, waited, !ret_val);
 	if (ret_val)
 		E1000_MUTEX_UNLOCK(&hw->dev_spec.ich8lan.swflag_mutex);
 
@@ -3104,6 +3108,34 @@ STATIC s32 e1000_valid_nvm_bank_detect_ich8lan(struct e1000_hw *hw, u32 *bank)
 	}
 }
 
+/**
+ *  e1000_get_nvm_bank_ich8lan - returns the valid bank 0 or 1
+ *  @hw: pointer to the HW structure
+ *  @bank:  pointer to the variable that returns the active bank
+ *
+ *  Returns the bank found by e1000_valid_nvm_bank_detect_ich8lan, which is
+ *  remembered until a reset, an NVM write or a checksum update, any of
+ *  which may switch banks.
+ **/
+STATIC s32 e1000_get_nvm_bank_ich8lan(struct e1000_hw *hw, u32 *bank)
+{
+	struct e1000_dev_spec_ich8lan *dev_spec = &hw->dev_spec.ich8lan;
+	s32 ret_val;
+
+	if (dev_spec->nvm_bank_cached) {
+		*bank = dev_spec->nvm_bank;
+		return E1000_SUCCESS;
+	}
+
+	ret_val = e1000_valid_nvm_bank_detect_ich8lan(hw, bank);
+	if (ret_val == E1000_SUCCESS) {
+		dev_spec->nvm_bank = *bank;
+		dev_spec->nvm_bank_cached = true;
+	}
+
+	return ret_val;
+}
+
 /**
  *  e1000_read_nvm_spt - NVM access for SPT
  *  @hw: pointer to the HW structure
@@ -3136,7 +3168,7 @@ STATIC s32 e1000_read_nvm_spt(struct e1000_hw *hw, u16 offset, u16 words,
 
 	nvm->ops.acquire(hw);
 
-	ret_val = e1000_valid_nvm_bank_detect_ich8lan(hw, &bank);
+	ret_val = e1000_get_nvm_bank_ich8lan(hw, &bank);
 	if (ret_val != E1000_SUCCESS) {
 		DEBUGOUT("Could not detect valid bank, assuming bank 0\n");
 		bank = 0;
@@ -3229,7 +3261,7 @@ STATIC s32 e1000_read_nvm_ich8lan(struct e1000_hw *hw, u16 offset, u16 words,
 
 	nvm->ops.acquire(hw);
 
-	ret_val = e1000_valid_nvm_bank_detect_ich8lan(hw, &bank);
+	ret_val = e1000_get_nvm_bank_ich8lan(hw, &bank);
 	if (ret_val != E1000_SUCCESS) {
 		DEBUGOUT("Could not detect valid bank, assuming bank 0\n");
 		bank = 0;
@@ -3654,6 +3686,9 @@ STATIC s32 e1000_write_nvm_ich8lan(struct e1000_hw *hw, u16 offset, u16 words,
 		dev_spec->shadow_ram[offset + i].value = data[i];
 	}
 
+	/* The checksum update that commits the words may switch banks */
+	dev_spec->nvm_bank_cached = false;
+
 	nvm->ops.release(hw);
 
 	return E1000_SUCCESS;
@@ -3804,6 +3839,8 @@ STATIC s32 e1000_update_nvm_checksum_spt(struct e1000_hw *hw)
 	}
 
 release:
+	/* The valid bank may have been switched or erased */
+	dev_spec->nvm_bank_cached = false;
 	nvm->ops.release(hw);
 
 	/* Reload the EEPROM, or else modifications will not appear
@@ -3957,6 +3994,8 @@ STATIC s32 e1000_update_nvm_checksum_ich8lan(struct e1000_hw *hw)
 	}
 
 release:
+	/* The valid bank may have been switched or erased */
+	dev_spec->nvm_bank_cached = false;
 	nvm->ops.release(hw);
 
 	/* Reload the EEPROM, or else modifications will not appear
@@ -4573,6 +4612,9 @@ STATIC s32 e1000_reset_hw_ich8lan(struct e1000_hw *hw)
 
 	DEBUGFUNC("e1000_reset_hw_ich8lan");
 
+	/* The NVM is reloaded by the reset, detect the valid bank again */
+	dev_spec->nvm_bank_cached = false;
+
 	/* Prevent the PCI-E bus from sticking if there is no TLP connection
 	 * on the last TLP read/write transaction when MAC is reset.
 	 */
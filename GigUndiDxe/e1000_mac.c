@@ -1735,6 +1735,31 @@ s32 e1000_get_speed_and_duplex_fiber_serdes_generic(struct e1000_hw E1000_UNUSED
 	return E1000_SUCCESS;
 }
 
+/**
+ *  e1000_sync_account - Record a semaphore acquisition attempt
+ *  @hw: pointer to the HW structure
+ *  @wait_usec: time spent waiting for the semaphore
+ *  @acquired: true if the semaphore was obtained
+ *
+ *  Updates the per-adapter contention and latency counters.
+ **/
+void e1000_sync_account(struct e1000_hw *hw, u32 wait_usec, bool acquired)
+{
+	struct e1000_sync_info *sync = &hw->sync;
+
+	if (acquired)
+		sync->acquisitions++;
+	else
+		sync->timeouts++;
+
+	if (wait_usec) {
+		sync->contended++;
+		sync->wait_usec += wait_usec;
+		if (wait_usec > sync->max_wait_usec)
+			sync->max_wait_usec = wait_usec;
+	}
+}
+
 /**
  *  e1000_get_hw_semaphore_generic - Acquire hardware semaphore
  *  @hw: pointer to the HW structure
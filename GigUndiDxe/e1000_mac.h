@@ -62,6 +62,7 @@ void e1000_set_lan_id_single_port(struct e1000_hw *hw);
 void e1000_set_lan_id_multi_port_pci(struct e1000_hw *hw);
 #endif
 s32  e1000_get_hw_semaphore_generic(struct e1000_hw *hw);
+void e1000_sync_account(struct e1000_hw *hw, u32 wait_usec, bool acquired);
 s32  e1000_get_speed_and_duplex_copper_generic(struct e1000_hw *hw, u16 *speed,
 					       u16 *duplex);
 s32  e1000_get_speed_and_duplex_fiber_serdes_generic(struct e1000_hw *hw,
@@ -801,6 +801,9 @@ s32 e1000_read_pba_string_generic(struct e1000_hw *hw, u8 *pba_num,
 	u16 pba_ptr;
 	u16 offset;
 	u16 length;
+	u16 pba_data[E1000_PBA_READ_CHUNK];
+	u16 count = 0;
+	u16 i;
 
 	DEBUGFUNC("e1000_read_pba_string_generic");
 
@@ -889,14 +892,22 @@ s32 e1000_read_pba_string_generic(struct e1000_hw *hw, u8 *pba_num,
 	pba_ptr++;
 	length--;
 
-	for (offset = 0; offset < length; offset++) {
-		ret_val = hw->nvm.ops.read(hw, pba_ptr + offset, 1, &nvm_data);
+	for (offset = 0; offset < length; offset += count) {
+		count = length - offset;
+		if (count > E1000_PBA_READ_CHUNK)
+			count = E1000_PBA_READ_CHUNK;
+		ret_val = hw->nvm.ops.read(hw, pba_ptr + offset, count,
+					   pba_data);
 		if (ret_val) {
 			DEBUGOUT("NVM Read Error\n");
 			return ret_val;
 		}
-		pba_num[offset * 2] = (u8)(nvm_data >> 8);
-		pba_num[(offset * 2) + 1] = (u8)(nvm_data & 0xFF);
+		for (i = 0; i < count; i++) {
+			nvm_data = pba_data[i];
+			pba_num[(offset + i) * 2] = (u8)(nvm_data >> 8);
+			pba_num[((offset + i) * 2) + 1] =
+				(u8)(nvm_data & 0xFF);
+		}
 	}
 	pba_num[offset * 2] = '\0';
 
@@ -1236,19 +1247,20 @@ s32 e1000_validate_nvm_checksum_generic(struct e1000_hw *hw)
 {
 	s32 ret_val;
 	u16 checksum = 0;
-	u16 i, nvm_data;
+	u16 nvm_data[NVM_CHECKSUM_REG + 1];
+	u16 i;
 
 	DEBUGFUNC("e1000_validate_nvm_checksum_generic");
 
-	for (i = 0; i < (NVM_CHECKSUM_REG + 1); i++) {
-		ret_val = hw->nvm.ops.read(hw, i, 1, &nvm_data);
-		if (ret_val) {
-			DEBUGOUT("NVM Read Error\n");
-			return ret_val;
-		}
-		checksum += nvm_data;
+	ret_val = hw->nvm.ops.read(hw, 0, NVM_CHECKSUM_REG + 1, nvm_data);
+	if (ret_val) {
+		DEBUGOUT("NVM Read Error\n");
+		return ret_val;
 	}
 
+	for (i = 0; i < (NVM_CHECKSUM_REG + 1); i++)
+		checksum += nvm_data[i];
+
 	if (checksum != (u16) NVM_SUM) {
 		DEBUGOUT("NVM Checksum Invalid\n");
 		return -E1000_ERR_NVM;
@@ -1309,4 +1321,286 @@ STATIC void e1000_reload_nvm_generic(struct e1000_hw *hw)
 	E1000_WRITE_FLUSH(hw);
 }
 
+/**
+ *  e1000_nvm_txn_begin - Opens an NVM write transaction
+ *  @hw: pointer to the HW structure
+ *
+ *  While a transaction is open e1000_write_nvm() stages words in
+ *  hw->nvm.txn instead of writing them, and e1000_update_nvm_checksum()
+ *  only records that an update is wanted.  Transactions nest; only the
+ *  outermost e1000_nvm_txn_commit() touches the NVM.
+ **/
+void e1000_nvm_txn_begin(struct e1000_hw *hw)
+{
+	struct e1000_nvm_txn *txn = &hw->nvm.txn;
+
+	DEBUGFUNC("e1000_nvm_txn_begin");
+
+	if (txn->depth++)
+		return;
+
+	txn->count = 0;
+	txn->sum_delta = 0;
+	txn->update_pending = false;
+	/* The delta can only patch a checksum that was good to begin with */
+	txn->incremental_ok = txn->checksum_valid;
+}
+
+/**
+ *  e1000_nvm_txn_flush - Writes out the staged words
+ *  @hw: pointer to the HW structure
+ *
+ *  Staged offsets are kept sorted, so each run of adjacent words goes out
+ *  in a single nvm.ops.write call.
+ **/
+STATIC s32 e1000_nvm_txn_flush(struct e1000_hw *hw)
+{
+	struct e1000_nvm_txn *txn = &hw->nvm.txn;
+	s32 ret_val = E1000_SUCCESS;
+	u16 run;
+	u16 i;
+
+	DEBUGFUNC("e1000_nvm_txn_flush");
+
+	if (!txn->count)
+		return E1000_SUCCESS;
+
+	txn->checksum_valid = false;
 
+	for (i = 0; i < txn->count; i += run) {
+		for (run = 1; i + run < txn->count; run++)
+			if (txn->offset[i + run] != txn->offset[i] + run)
+				break;
+
+		ret_val = hw->nvm.ops.write(hw, txn->offset[i], run,
+					    &txn->data[i]);
+		if (ret_val) {
+			DEBUGOUT("NVM Write Error while flushing transaction.\n");
+			break;
+		}
+	}
+
+	txn->count = 0;
+
+	return ret_val;
+}
+
+/**
+ *  e1000_nvm_txn_stage - Stages words in the open NVM transaction
+ *  @hw: pointer to the HW structure
+ *  @offset: offset within the EEPROM to be written to
+ *  @words: number of words to write
+ *  @data: 16 bit word(s) to be written to the EEPROM
+ *
+ *  Records the words in the transaction and folds their difference to the
+ *  current contents into the running checksum delta.  A word staged twice
+ *  only keeps the latest value.  Nothing reaches the NVM before the
+ *  commit, so a transaction that does not fit the table fails instead.
+ **/
+s32 e1000_nvm_txn_stage(struct e1000_hw *hw, u16 offset, u16 words,
+			u16 *data)
+{
+	struct e1000_nvm_info *nvm = &hw->nvm;
+	struct e1000_nvm_txn *txn = &nvm->txn;
+	s32 ret_val;
+	u16 old, word;
+	u16 i, pos, j;
+
+	DEBUGFUNC("e1000_nvm_txn_stage");
+
+	if ((offset >= nvm->word_size) || (words > (nvm->word_size - offset)) ||
+	    (words == 0)) {
+		DEBUGOUT("nvm parameter(s) out of bounds\n");
+		return -E1000_ERR_NVM;
+	}
+
+	for (i = 0; i < words; i++) {
+		word = offset + i;
+		old = 0;
+
+		for (pos = 0; pos < txn->count; pos++)
+			if (txn->offset[pos] >= word)
+				break;
+
+		if (pos < txn->count && txn->offset[pos] == word) {
+			old = txn->data[pos];
+		} else {
+			if (txn->count == E1000_NVM_TXN_WORDS) {
+				DEBUGOUT("NVM transaction full\n");
+				return -E1000_ERR_NVM;
+			}
+
+			if (word < NVM_CHECKSUM_REG && txn->incremental_ok &&
+			    nvm->ops.read(hw, word, 1, &old))
+				txn->incremental_ok = false;
+
+			for (j = txn->count; j > pos; j--) {
+				txn->offset[j] = txn->offset[j - 1];
+				txn->data[j] = txn->data[j - 1];
+			}
+			txn->offset[pos] = word;
+			txn->count++;
+		}
+
+		if (word < NVM_CHECKSUM_REG)
+			txn->sum_delta += data[i] - old;
+		else if (word == NVM_CHECKSUM_REG)
+			txn->incremental_ok = false;
+
+		txn->data[pos] = data[i];
+	}
+
+	return E1000_SUCCESS;
+}
+
+/**
+ *  e1000_nvm_txn_overlay - Applies staged words to NVM read data
+ *  @hw: pointer to the HW structure
+ *  @offset: offset of word in the EEPROM that was read
+ *  @words: number of words read
+ *  @data: words read from the EEPROM
+ *
+ *  Makes reads inside an open transaction see the staged values.
+ **/
+void e1000_nvm_txn_overlay(struct e1000_hw *hw, u16 offset, u16 words,
+			   u16 *data)
+{
+	struct e1000_nvm_txn *txn = &hw->nvm.txn;
+	u16 i;
+
+	for (i = 0; i < txn->count; i++)
+		if (txn->offset[i] >= offset &&
+		    (u32)txn->offset[i] < (u32)offset + words)
+			data[txn->offset[i] - offset] = txn->data[i];
+}
+
+/**
+ *  e1000_nvm_txn_incremental - Checks for a patchable checksum scheme
+ *  @hw: pointer to the HW structure
+ *
+ *  Returns true when nvm.ops.update only rewrites the single checksum word
+ *  (plus the flash commit on i210), so the checksum can be patched from the
+ *  word delta.  Parts with per-port checksums or flash bank switching keep
+ *  their own update routine.
+ **/
+STATIC bool e1000_nvm_txn_incremental(struct e1000_hw *hw)
+{
+	if (hw->nvm.ops.update == e1000_update_nvm_checksum_generic)
+		return true;
+#ifndef NO_I210_SUPPORT
+	if (hw->nvm.ops.update == e1000_update_nvm_checksum_i210)
+		return true;
+#endif /* NO_I210_SUPPORT */
+
+	return false;
+}
+
+/**
+ *  e1000_nvm_txn_patch_checksum - Applies the word delta to the checksum
+ *  @hw: pointer to the HW structure
+ **/
+STATIC s32 e1000_nvm_txn_patch_checksum(struct e1000_hw *hw)
+{
+	struct e1000_nvm_txn *txn = &hw->nvm.txn;
+	u16 checksum;
+	s32 ret_val;
+
+	DEBUGFUNC("e1000_nvm_txn_patch_checksum");
+
+	ret_val = hw->nvm.ops.read(hw, NVM_CHECKSUM_REG, 1, &checksum);
+	if (ret_val)
+		return ret_val;
+
+	checksum -= txn->sum_delta;
+	ret_val = hw->nvm.ops.write(hw, NVM_CHECKSUM_REG, 1, &checksum);
+	if (ret_val) {
+		DEBUGOUT("NVM Write Error while updating checksum.\n");
+		return ret_val;
+	}
+
+#ifndef NO_I210_SUPPORT
+	if (hw->nvm.ops.update == e1000_update_nvm_checksum_i210)
+		ret_val = e1000_update_flash_i210(hw);
+#endif /* NO_I210_SUPPORT */
+
+	return ret_val;
+}
+
+/**
+ *  e1000_nvm_txn_commit - Closes an NVM write transaction
+ *  @hw: pointer to the HW structure
+ *
+ *  On the outermost commit writes out the staged words and, if a checksum
+ *  update was requested, performs it once: patched from the word delta
+ *  where the part allows it, otherwise through nvm.ops.update.  Nothing is
+ *  written when no word changed and the checksum is already known good.
+ **/
+s32 e1000_nvm_txn_commit(struct e1000_hw *hw)
+{
+	struct e1000_nvm_txn *txn = &hw->nvm.txn;
+	bool patched = false;
+	u16 staged;
+	s32 ret_val;
+
+	DEBUGFUNC("e1000_nvm_txn_commit");
+
+	if (!txn->depth)
+		return E1000_SUCCESS;
+	if (--txn->depth)
+		return E1000_SUCCESS;
+
+	staged = txn->count;
+
+	ret_val = e1000_nvm_txn_flush(hw);
+	if (ret_val)
+		goto out;
+
+	if (!txn->update_pending || (!staged && txn->checksum_valid))
+		goto out;
+
+	if (!hw->nvm.ops.update) {
+		ret_val = -E1000_ERR_CONFIG;
+		goto out;
+	}
+
+	if (txn->incremental_ok && e1000_nvm_txn_incremental(hw)) {
+		patched = true;
+		ret_val = e1000_nvm_txn_patch_checksum(hw);
+	} else {
+		ret_val = hw->nvm.ops.update(hw);
+	}
+
+	if (!ret_val)
+		txn->checksum_valid = true;
+
+out:
+	DEBUGOUT3("NVM transaction: %d words, checksum %s, status %d\n",
+		  staged, txn->update_pending ? (patched ? "patched" :
+		  "updated") : "untouched", ret_val);
+	txn->update_pending = false;
+
+	return ret_val;
+}
+
+/**
+ *  e1000_nvm_txn_abort - Drops an open NVM write transaction
+ *  @hw: pointer to the HW structure
+ *
+ *  Discards the staged words regardless of nesting.  Words are only
+ *  written on commit, so the NVM is left as it was before the transaction.
+ **/
+void e1000_nvm_txn_abort(struct e1000_hw *hw)
+{
+	struct e1000_nvm_txn *txn = &hw->nvm.txn;
+
+	DEBUGFUNC("e1000_nvm_txn_abort");
+
+	if (!txn->depth)
+		return;
+
+	DEBUGOUT1("NVM transaction aborted, %d staged\n", txn->count);
+
+	txn->depth = 0;
+	txn->count = 0;
+	txn->update_pending = false;
+}
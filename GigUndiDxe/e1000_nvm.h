@@ -88,6 +88,13 @@ s32  e1000_write_nvm_spi(struct e1000_hw *hw, u16 offset, u16 words,
 			 u16 *data);
 s32  e1000_update_nvm_checksum_generic(struct e1000_hw *hw);
 void e1000_release_nvm_generic(struct e1000_hw *hw);
+void e1000_nvm_txn_begin(struct e1000_hw *hw);
+s32  e1000_nvm_txn_stage(struct e1000_hw *hw, u16 offset, u16 words,
+			 u16 *data);
+void e1000_nvm_txn_overlay(struct e1000_hw *hw, u16 offset, u16 words,
+			   u16 *data);
+s32  e1000_nvm_txn_commit(struct e1000_hw *hw);
+void e1000_nvm_txn_abort(struct e1000_hw *hw);
 
 #define E1000_STM_OPCODE	0xDB00
 
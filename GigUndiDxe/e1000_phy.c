@@ -267,6 +267,56 @@ s32 e1000_phy_reset_dsp_generic(struct e1000_hw *hw)
 	return hw->phy.ops.write_reg(hw, M88E1000_PHY_GEN_CONTROL, 0);
 }
 
+/**
+ *  e1000_poll_mdic - Wait for MDI control register transaction to complete
+ *  @hw: pointer to the HW structure
+ *
+ *  Looks at MDIC first after the completion time measured for earlier
+ *  transactions, then polls with an interval growing from
+ *  E1000_MDIC_POLL_MIN_USEC to E1000_MDIC_POLL_MAX_USEC.  The estimate is
+ *  lowered by a microsecond whenever the first look succeeds, so it follows
+ *  the MDIO clock of the part.  Returns the last value read from MDIC.
+ **/
+STATIC u32 e1000_poll_mdic(struct e1000_hw *hw)
+{
+	struct e1000_phy_info *phy = &hw->phy;
+	u32 mdic, delay, waited;
+
+	if (!phy->mdic_wait_usec)
+		phy->mdic_wait_usec = E1000_MDIC_POLL_MAX_USEC;
+
+	waited = phy->mdic_wait_usec;
+	usec_delay_irq(waited);
+	mdic = E1000_READ_REG(hw, E1000_MDIC);
+
+	if (mdic & E1000_MDIC_READY) {
+		if (phy->mdic_wait_usec > E1000_MDIC_POLL_MIN_USEC)
+			phy->mdic_wait_usec--;
+	} else {
+		delay = E1000_MDIC_POLL_MIN_USEC;
+		while (waited < E1000_MDIC_POLL_BUDGET_USEC) {
+			usec_delay_irq(delay);
+			waited += delay;
+			mdic = E1000_READ_REG(hw, E1000_MDIC);
+			if (mdic & E1000_MDIC_READY)
+				break;
+			if (delay < E1000_MDIC_POLL_MAX_USEC)
+				delay = (delay * 2 < E1000_MDIC_POLL_MAX_USEC) ?
+					delay * 2 : E1000_MDIC_POLL_MAX_USEC;
+		}
+		if ((mdic & E1000_MDIC_READY) &&
+		    (waited <= E1000_MDIC_POLL_MAX_USEC))
+			phy->mdic_wait_usec = waited;
+		else if (mdic & E1000_MDIC_READY)
+			phy->mdic_wait_usec = E1000_MDIC_POLL_MAX_USEC;
+	}
+
+	phy->mdio_transactions++;
+	phy->mdio_usec += waited;
+
+	return mdic;
+}
+
 /**
  *  e1000_read_phy_reg_mdic - Read MDI control register
  *  @hw: pointer to the HW structure
@@ -279,7 +329,7 @@ s32 e1000_phy_reset_dsp_generic(struct e1000_hw *hw)
 s32 e1000_read_phy_reg_mdic(struct e1000_hw *hw, u32 offset, u16 *data)
 {
 	struct e1000_phy_info *phy = &hw->phy;
-	u32 i, mdic = 0;
+	u32 mdic = 0;
 
 	DEBUGFUNC("e1000_read_phy_reg_mdic");
 
@@ -298,16 +348,8 @@ s32 e1000_read_phy_reg_mdic(struct e1000_hw *hw, u32 offset, u16 *data)
 
 	E1000_WRITE_REG(hw, E1000_MDIC, mdic);
 
-	/* Poll the ready bit to see if the MDI read completed
-	 * Increasing the time out as testing showed failures with
-	 * the lower time out
-	 */
-	for (i = 0; i < (E1000_GEN_POLL_TIMEOUT * 3); i++) {
-		usec_delay_irq(50);
-		mdic = E1000_READ_REG(hw, E1000_MDIC);
-		if (mdic & E1000_MDIC_READY)
-			break;
-	}
+	/* Poll the ready bit to see if the MDI read completed */
+	mdic = e1000_poll_mdic(hw);
 	if (!(mdic & E1000_MDIC_READY)) {
 		DEBUGOUT("MDI Read did not complete\n");
 		return -E1000_ERR_PHY;
@@ -346,7 +388,7 @@ s32 e1000_read_phy_reg_mdic(struct e1000_hw *hw, u32 offset, u16 *data)
 s32 e1000_write_phy_reg_mdic(struct e1000_hw *hw, u32 offset, u16 data)
 {
 	struct e1000_phy_info *phy = &hw->phy;
-	u32 i, mdic = 0;
+	u32 mdic = 0;
 
 	DEBUGFUNC("e1000_write_phy_reg_mdic");
 
@@ -366,16 +408,8 @@ s32 e1000_write_phy_reg_mdic(struct e1000_hw *hw, u32 offset, u16 data)
 
 	E1000_WRITE_REG(hw, E1000_MDIC, mdic);
 
-	/* Poll the ready bit to see if the MDI read completed
-	 * Increasing the time out as testing showed failures with
-	 * the lower time out
-	 */
-	for (i = 0; i < (E1000_GEN_POLL_TIMEOUT * 3); i++) {
-		usec_delay_irq(50);
-		mdic = E1000_READ_REG(hw, E1000_MDIC);
-		if (mdic & E1000_MDIC_READY)
-			break;
-	}
+	/* Poll the ready bit to see if the MDI write completed */
+	mdic = e1000_poll_mdic(hw);
 	if (!(mdic & E1000_MDIC_READY)) {
 		DEBUGOUT("MDI Write did not complete\n");
 		return -E1000_ERR_PHY;
@@ -635,6 +669,69 @@ s32 e1000_write_sfp_data_byte(struct e1000_hw *hw, u16 offset, u8 data)
 	return E1000_SUCCESS;
 }
 
+/**
+ *  e1000_read_sfp_data_block - Reads a block of SFP module data.
+ *  @hw: pointer to the HW structure
+ *  @offset: byte location offset of the first byte to be read
+ *  @data: read data buffer pointer
+ *  @length: number of bytes to read
+ *  @wait_usec: if not NULL, incremented by the time spent polling
+ *
+ *  Reads SFP module data two bytes per I2CCMD transaction: the data field
+ *  of the command returns the byte at the requested offset in the low
+ *  lane and the following byte in the high lane.  Offsets are encoded
+ *  as for e1000_read_sfp_data_byte.
+ **/
+s32 e1000_read_sfp_data_block(struct e1000_hw *hw, u16 offset, u8 *data,
+			      u16 length, u32 *wait_usec)
+{
+	u32 i2ccmd;
+	u32 i;
+	u16 pos;
+
+	DEBUGFUNC("e1000_read_sfp_data_block");
+
+	if (!length)
+		return E1000_SUCCESS;
+
+	if ((u32)offset + length - 1 > E1000_I2CCMD_SFP_DIAG_ADDR(255)) {
+		DEBUGOUT("I2CCMD command address exceeds upper limit\n");
+		return -E1000_ERR_PHY;
+	}
+
+	for (pos = 0; pos < length; pos += 2) {
+		E1000_WRITE_REG(hw, E1000_I2CCMD,
+				((u32)(offset + pos) <<
+				 E1000_I2CCMD_REG_ADDR_SHIFT) |
+				E1000_I2CCMD_OPCODE_READ);
+
+		/* Poll the ready bit to see if the I2C read completed */
+		i2ccmd = 0;
+		for (i = 0; i < E1000_I2CCMD_PHY_TIMEOUT; i++) {
+			usec_delay(50);
+			if (wait_usec)
+				*wait_usec += 50;
+			i2ccmd = E1000_READ_REG(hw, E1000_I2CCMD);
+			if (i2ccmd & E1000_I2CCMD_READY)
+				break;
+		}
+		if (!(i2ccmd & E1000_I2CCMD_READY)) {
+			DEBUGOUT("I2CCMD Read did not complete\n");
+			return -E1000_ERR_PHY;
+		}
+		if (i2ccmd & E1000_I2CCMD_ERROR) {
+			DEBUGOUT("I2CCMD Error bit set\n");
+			return -E1000_ERR_PHY;
+		}
+
+		data[pos] = (u8)(i2ccmd & 0xFF);
+		if (pos + 1 < length)
+			data[pos + 1] = (u8)((i2ccmd >> 8) & 0xFF);
+	}
+
+	return E1000_SUCCESS;
+}
+
 #endif /* NO_82575_SUPPORT */
 /**
  *  e1000_read_phy_reg_m88 - Read m88 PHY register
@@ -717,10 +814,39 @@ s32 e1000_set_page_igp(struct e1000_hw *hw, u16 page)
 	DEBUGOUT1("Setting page 0x%x\n", page);
 
 	hw->phy.addr = 1;
+	hw->phy.page_shadow_valid = false;
 
 	return e1000_write_phy_reg_mdic(hw, IGP01E1000_PHY_PAGE_SELECT, page);
 }
 
+/**
+ *  e1000_select_page_igp - Select page of multi-page IGP PHY register
+ *  @hw: pointer to the HW structure
+ *  @offset: register offset including the page
+ *
+ *  Writes the page select register unless a PHY register sequence already
+ *  selected the same page; the page is owned by the driver while the
+ *  semaphore is held for the whole sequence.  Assumes semaphore is already
+ *  acquired.
+ **/
+STATIC s32 e1000_select_page_igp(struct e1000_hw *hw, u32 offset)
+{
+	struct e1000_phy_info *phy = &hw->phy;
+	u16 page = (u16)(offset & ~MAX_PHY_REG_ADDRESS);
+	s32 ret_val;
+
+	if (phy->in_sequence && phy->page_shadow_valid &&
+	    (phy->page_shadow == page))
+		return E1000_SUCCESS;
+
+	ret_val = e1000_write_phy_reg_mdic(hw, IGP01E1000_PHY_PAGE_SELECT,
+					   (u16)offset);
+	phy->page_shadow = page;
+	phy->page_shadow_valid = phy->in_sequence && !ret_val;
+
+	return ret_val;
+}
+
 /**
  *  __e1000_read_phy_reg_igp - Read igp PHY register
  *  @hw: pointer to the HW structure
@@ -749,9 +875,7 @@ STATIC s32 __e1000_read_phy_reg_igp(struct e1000_hw *hw, u32 offset, u16 *data,
 	}
 
 	if (offset > MAX_PHY_MULTI_PAGE_REG)
-		ret_val = e1000_write_phy_reg_mdic(hw,
-						   IGP01E1000_PHY_PAGE_SELECT,
-						   (u16)offset);
+		ret_val = e1000_select_page_igp(hw, offset);
 	if (!ret_val)
 		ret_val = e1000_read_phy_reg_mdic(hw,
 						  MAX_PHY_REG_ADDRESS & offset,
@@ -818,9 +942,7 @@ STATIC s32 __e1000_write_phy_reg_igp(struct e1000_hw *hw, u32 offset, u16 data,
 	}
 
 	if (offset > MAX_PHY_MULTI_PAGE_REG)
-		ret_val = e1000_write_phy_reg_mdic(hw,
-						   IGP01E1000_PHY_PAGE_SELECT,
-						   (u16)offset);
+		ret_val = e1000_select_page_igp(hw, offset);
 	if (!ret_val)
 		ret_val = e1000_write_phy_reg_mdic(hw, MAX_PHY_REG_ADDRESS &
 						       offset,
@@ -3015,85 +3137,146 @@ s32 e1000_get_cfg_done_generic(struct e1000_hw E1000_UNUSEDARG *hw)
 	return E1000_SUCCESS;
 }
 
-/**
- *  e1000_phy_init_script_igp3 - Inits the IGP3 PHY
- *  @hw: pointer to the HW structure
- *
- *  Initializes a Intel Gigabit PHY3 when an EEPROM is not present.
- **/
-s32 e1000_phy_init_script_igp3(struct e1000_hw *hw)
-{
-	DEBUGOUT("Running IGP 3 PHY init script\n");
-
-	/* PHY init IGP 3 */
+/* PHY init IGP 3 */
+STATIC const struct e1000_phy_reg_write e1000_igp3_init_script[] = {
 	/* Enable rise/fall, 10-mode work in class-A */
-	hw->phy.ops.write_reg(hw, 0x2F5B, 0x9018);
+	{ 0x2F5B, 0x9018 },
 	/* Remove all caps from Replica path filter */
-	hw->phy.ops.write_reg(hw, 0x2F52, 0x0000);
+	{ 0x2F52, 0x0000 },
 	/* Bias trimming for ADC, AFE and Driver (Default) */
-	hw->phy.ops.write_reg(hw, 0x2FB1, 0x8B24);
+	{ 0x2FB1, 0x8B24 },
 	/* Increase Hybrid poly bias */
-	hw->phy.ops.write_reg(hw, 0x2FB2, 0xF8F0);
+	{ 0x2FB2, 0xF8F0 },
 	/* Add 4% to Tx amplitude in Gig mode */
-	hw->phy.ops.write_reg(hw, 0x2010, 0x10B0);
+	{ 0x2010, 0x10B0 },
 	/* Disable trimming (TTT) */
-	hw->phy.ops.write_reg(hw, 0x2011, 0x0000);
+	{ 0x2011, 0x0000 },
 	/* Poly DC correction to 94.6% + 2% for all channels */
-	hw->phy.ops.write_reg(hw, 0x20DD, 0x249A);
+	{ 0x20DD, 0x249A },
 	/* ABS DC correction to 95.9% */
-	hw->phy.ops.write_reg(hw, 0x20DE, 0x00D3);
+	{ 0x20DE, 0x00D3 },
 	/* BG temp curve trim */
-	hw->phy.ops.write_reg(hw, 0x28B4, 0x04CE);
+	{ 0x28B4, 0x04CE },
 	/* Increasing ADC OPAMP stage 1 currents to max */
-	hw->phy.ops.write_reg(hw, 0x2F70, 0x29E4);
+	{ 0x2F70, 0x29E4 },
 	/* Force 1000 ( required for enabling PHY regs configuration) */
-	hw->phy.ops.write_reg(hw, 0x0000, 0x0140);
+	{ 0x0000, 0x0140 },
 	/* Set upd_freq to 6 */
-	hw->phy.ops.write_reg(hw, 0x1F30, 0x1606);
+	{ 0x1F30, 0x1606 },
 	/* Disable NPDFE */
-	hw->phy.ops.write_reg(hw, 0x1F31, 0xB814);
+	{ 0x1F31, 0xB814 },
 	/* Disable adaptive fixed FFE (Default) */
-	hw->phy.ops.write_reg(hw, 0x1F35, 0x002A);
+	{ 0x1F35, 0x002A },
 	/* Enable FFE hysteresis */
-	hw->phy.ops.write_reg(hw, 0x1F3E, 0x0067);
+	{ 0x1F3E, 0x0067 },
 	/* Fixed FFE for short cable lengths */
-	hw->phy.ops.write_reg(hw, 0x1F54, 0x0065);
+	{ 0x1F54, 0x0065 },
 	/* Fixed FFE for medium cable lengths */
-	hw->phy.ops.write_reg(hw, 0x1F55, 0x002A);
+	{ 0x1F55, 0x002A },
 	/* Fixed FFE for long cable lengths */
-	hw->phy.ops.write_reg(hw, 0x1F56, 0x002A);
+	{ 0x1F56, 0x002A },
 	/* Enable Adaptive Clip Threshold */
-	hw->phy.ops.write_reg(hw, 0x1F72, 0x3FB0);
+	{ 0x1F72, 0x3FB0 },
 	/* AHT reset limit to 1 */
-	hw->phy.ops.write_reg(hw, 0x1F76, 0xC0FF);
+	{ 0x1F76, 0xC0FF },
 	/* Set AHT master delay to 127 msec */
-	hw->phy.ops.write_reg(hw, 0x1F77, 0x1DEC);
+	{ 0x1F77, 0x1DEC },
 	/* Set scan bits for AHT */
-	hw->phy.ops.write_reg(hw, 0x1F78, 0xF9EF);
+	{ 0x1F78, 0xF9EF },
 	/* Set AHT Preset bits */
-	hw->phy.ops.write_reg(hw, 0x1F79, 0x0210);
+	{ 0x1F79, 0x0210 },
 	/* Change integ_factor of channel A to 3 */
-	hw->phy.ops.write_reg(hw, 0x1895, 0x0003);
+	{ 0x1895, 0x0003 },
 	/* Change prop_factor of channels BCD to 8 */
-	hw->phy.ops.write_reg(hw, 0x1796, 0x0008);
+	{ 0x1796, 0x0008 },
 	/* Change cg_icount + enable integbp for channels BCD */
-	hw->phy.ops.write_reg(hw, 0x1798, 0xD008);
+	{ 0x1798, 0xD008 },
 	/* Change cg_icount + enable integbp + change prop_factor_master
 	 * to 8 for channel A
 	 */
-	hw->phy.ops.write_reg(hw, 0x1898, 0xD918);
+	{ 0x1898, 0xD918 },
 	/* Disable AHT in Slave mode on channel A */
-	hw->phy.ops.write_reg(hw, 0x187A, 0x0800);
+	{ 0x187A, 0x0800 },
 	/* Enable LPLU and disable AN to 1000 in non-D0a states,
 	 * Enable SPD+B2B
 	 */
-	hw->phy.ops.write_reg(hw, 0x0019, 0x008D);
+	{ 0x0019, 0x008D },
 	/* Enable restart AN on an1000_dis change */
-	hw->phy.ops.write_reg(hw, 0x001B, 0x2080);
+	{ 0x001B, 0x2080 },
 	/* Enable wh_fifo read clock in 10/100 modes */
-	hw->phy.ops.write_reg(hw, 0x0014, 0x0045);
+	{ 0x0014, 0x0045 },
 	/* Restart AN, Speed selection is 1000 */
-	hw->phy.ops.write_reg(hw, 0x0000, 0x1340);
+	{ 0x0000, 0x1340 },
+};
+
+/**
+ *  e1000_write_phy_reg_seq - Write a sequence of PHY registers
+ *  @hw: pointer to the HW structure
+ *  @seq: registers and values to be written in order
+ *  @count: number of entries in seq
+ *
+ *  Writes all registers of the sequence under a single acquisition of the
+ *  PHY semaphore when the PHY has locked accessors, otherwise one register
+ *  at a time.  All registers are written even if one fails; the first
+ *  error is returned.
+ **/
+s32 e1000_write_phy_reg_seq(struct e1000_hw *hw,
+			    const struct e1000_phy_reg_write *seq, u32 count)
+{
+	struct e1000_phy_info *phy = &hw->phy;
+	s32 ret_val = E1000_SUCCESS;
+	s32 status;
+	u32 i;
+
+	DEBUGFUNC("e1000_write_phy_reg_seq");
+
+	if (!phy->ops.acquire ||
+	    (phy->ops.write_reg_locked == e1000_null_write_reg)) {
+		for (i = 0; i < count; i++) {
+			status = phy->ops.write_reg(hw, seq[i].offset,
+						    seq[i].data);
+			if (!ret_val)
+				ret_val = status;
+		}
+		return ret_val;
+	}
+
+	ret_val = phy->ops.acquire(hw);
+	if (ret_val)
+		return ret_val;
+
+	phy->in_sequence = true;
+	phy->page_shadow_valid = false;
+
+	for (i = 0; i < count; i++) {
+		status = phy->ops.write_reg_locked(hw, seq[i].offset,
+						   seq[i].data);
+		if (!ret_val)
+			ret_val = status;
+	}
+
+	phy->in_sequence = false;
+	phy->page_shadow_valid = false;
+
+	phy->ops.release(hw);
+
+	return ret_val;
+}
+
+/**
+ *  e1000_phy_init_script_igp3 - Inits the IGP3 PHY
+ *  @hw: pointer to the HW structure
+ *
+ *  Initializes a Intel Gigabit PHY3 when an EEPROM is not present.
+ **/
+s32 e1000_phy_init_script_igp3(struct e1000_hw *hw)
+{
+	DEBUGOUT("Running IGP 3 PHY init script\n");
+
+	/* Page selects are skipped between registers of the same page */
+	e1000_write_phy_reg_seq(hw, e1000_igp3_init_script,
+				sizeof(e1000_igp3_init_script) /
+				sizeof(e1000_igp3_init_script[0]));
 
 	return E1000_SUCCESS;
 }
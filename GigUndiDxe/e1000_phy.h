@@ -80,6 +80,8 @@ s32  e1000_write_phy_reg_m88(struct e1000_hw *hw, u32 offset, u16 data);
 s32  e1000_phy_has_link_generic(struct e1000_hw *hw, u32 iterations,
 				u32 usec_interval, bool *success);
 s32  e1000_phy_init_script_igp3(struct e1000_hw *hw);
+s32  e1000_write_phy_reg_seq(struct e1000_hw *hw,
+			     const struct e1000_phy_reg_write *seq, u32 count);
 enum e1000_phy_type e1000_get_phy_type_from_id(u32 phy_id);
 s32  e1000_determine_phy_address(struct e1000_hw *hw);
 #ifndef NO_ICH8LAN_SUPPORT
@@ -101,6 +103,8 @@ s32  e1000_read_phy_reg_i2c(struct e1000_hw *hw, u32 offset, u16 *data);
 s32  e1000_write_phy_reg_i2c(struct e1000_hw *hw, u32 offset, u16 data);
 s32  e1000_read_sfp_data_byte(struct e1000_hw *hw, u16 offset, u8 *data);
 s32  e1000_write_sfp_data_byte(struct e1000_hw *hw, u16 offset, u8 data);
+s32  e1000_read_sfp_data_block(struct e1000_hw *hw, u16 offset, u8 *data,
+			       u16 length, u32 *wait_usec);
 #endif /* *NO_82575_SUPPORT */
 #ifndef NO_ICH8LAN_SUPPORT
 s32  e1000_read_phy_reg_hv(struct e1000_hw *hw, u32 offset, u16 *data);
@@ -329,6 +333,12 @@ s32 e1000_write_xmdio_reg(struct e1000_hw *hw, u16 addr, u8 dev_addr,
 #define E1000_SFF_IDENTIFIER_SFP	0x03
 
 #define E1000_SFF_ETH_FLAGS_OFFSET	0x06
+#define E1000_SFF_BITRATE_OFFSET	0x0C
+#define E1000_SFF_VENDOR_NAME_OFFSET	0x14
+#define E1000_SFF_VENDOR_PN_OFFSET	0x28
+#define E1000_SFF_VENDOR_STR_LEN	16
+/* Base ID fields of the A0h page held in the SFP cache */
+#define E1000_SFF_CACHE_SIZE		0x60
 /* Flags for SFP modules compatible with ETH up to 1Gb */
 struct sfp_e1000_flags {
 	u8 e1000_base_sx:1;
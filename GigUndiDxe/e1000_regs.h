@@ -222,6 +222,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define E1000_INVM_DATA_REG(_n)	(0x12120 + 4*(_n))
 #define E1000_INVM_SIZE		64 /* Number of INVM Data Registers */
+#define E1000_INVM_WORD_ADDRESSES	128 /* 7-bit word autoload address */
 #endif /* !NO_I210_SUPPORT || !NO_I225_SUPPORT */
 
 #ifndef NO_I210_SUPPORT
@@ -56,15 +56,58 @@ static BOOLEAN _WolMatchDeviceId(
          _WolMatchId(DeviceId->SubDeviceId, Pattern->SubDeviceId);
 }
 
+static BOOLEAN _WolIsBeforeDevice(
+  _WOL_DEVICE_INFO_t const *DeviceInfo,
+  _WOL_DEVICE_ID_t *DeviceId
+) {
+  if (DeviceInfo->VendorId != DeviceId->VendorId) {
+    return DeviceInfo->VendorId < DeviceId->VendorId;
+  }
+  return DeviceInfo->DeviceId < DeviceId->DeviceId;
+}
+
+/* The device info table is generated sorted by vendor, device, subvendor and
+ * subdevice, with wildcards only in the subsystem IDs. A binary search finds the
+ * entries of the device, and the first match among them is the one a scan
+ * of the whole table would return, as the 0xFFFF wildcards sort last.
+ */
 static _WOL_DEVICE_INFO_t *_WolFindDeviceInfo(
   _WOL_DEVICE_ID_t *DeviceId,
   _WOL_DEVICE_INFO_t *DeviceInfoTable
 ) {
-  while (!_WolIsDevInfoEmpty(DeviceInfoTable)) {
-    if (_WolMatchDeviceId(DeviceId, (_WOL_DEVICE_ID_t *)DeviceInfoTable)) {
-      return DeviceInfoTable;
+  static _WOL_DEVICE_INFO_t *CountedTable = NULL;
+  static UINT32 TableSize = 0;
+  UINT32 Low;
+  UINT32 High;
+  UINT32 Mid;
+
+  if (CountedTable != DeviceInfoTable) {
+    TableSize = 0;
+    while (!_WolIsDevInfoEmpty(&DeviceInfoTable[TableSize])) {
+      ++TableSize;
+    }
+    CountedTable = DeviceInfoTable;
+  }
+
+  Low = 0;
+  High = TableSize;
+  while (Low < High) {
+    Mid = Low + (High - Low) / 2;
+    if (_WolIsBeforeDevice(&DeviceInfoTable[Mid], DeviceId)) {
+      Low = Mid + 1;
+    } else {
+      High = Mid;
+    }
+  }
+
+  for (; Low < TableSize; ++Low) {
+    if (DeviceInfoTable[Low].VendorId != DeviceId->VendorId ||
+        DeviceInfoTable[Low].DeviceId != DeviceId->DeviceId) {
+      break;
+    }
+    if (_WolMatchDeviceId(DeviceId, (_WOL_DEVICE_ID_t *)&DeviceInfoTable[Low])) {
+      return &DeviceInfoTable[Low];
     }
-    ++DeviceInfoTable;
   }
 
   return NULL;